@@ -30,7 +30,7 @@ if notExists "${USER_INPUT_CONTIGS}.dbtype"; then
         echo "neither ${USER_INPUT_CONTIGS} nor ${USER_INPUT_CONTIGS}.dbtype was found!" && exit 1;
     fi
     # shellcheck disable=SC2086
-    "$MMSEQS" createdb "${USER_INPUT_CONTIGS}" "${TMP_PATH}/contigs" --dbtype 2 ${VERBOSITY_COMP_PAR} \
+    "$MMSEQS" createdb "${USER_INPUT_CONTIGS}" "${TMP_PATH}/contigs" --dbtype 2 ${THREAD_COMP_PAR} ${CONTIGS_CREATEDB_PAR} \
             || fail "contigs createdb died"
     INPUT_CONTIGS="${TMP_PATH}/contigs"
 else
@@ -45,10 +45,26 @@ if notExists "${USER_INPUT_TARGETS}.dbtype"; then
     if notExists "${USER_INPUT_TARGETS}"; then
         echo "neither ${USER_INPUT_TARGETS} nor ${USER_INPUT_TARGETS}.dbtype was found!" && exit 1;
     fi
-    # shellcheck disable=SC2086
-    "$MMSEQS" createdb "${USER_INPUT_TARGETS}" "${TMP_PATH}/targets" --dbtype 1 ${VERBOSITY_COMP_PAR} \
-            || fail "targets createdb died"
-    INPUT_TARGETS="${TMP_PATH}/targets"
+    if [ -n "${TARGET_DB}" ]; then
+        # the target database and its index are kept for later runs against the same fasta
+        INPUT_TARGETS="${TARGET_DB}"
+        if [ -f "${INPUT_TARGETS}.dbtype" ] && [ "${USER_INPUT_TARGETS}" -nt "${INPUT_TARGETS}.dbtype" ]; then
+            echo "${USER_INPUT_TARGETS} changed, recreating ${INPUT_TARGETS}"
+            "$MMSEQS" rmdb "${INPUT_TARGETS}.idx" ${VERBOSITY_PAR}
+            "$MMSEQS" rmdb "${INPUT_TARGETS}_h" ${VERBOSITY_PAR}
+            "$MMSEQS" rmdb "${INPUT_TARGETS}" ${VERBOSITY_PAR}
+        fi
+        if notExists "${INPUT_TARGETS}.dbtype"; then
+            # shellcheck disable=SC2086
+            "$MMSEQS" createdb "${USER_INPUT_TARGETS}" "${INPUT_TARGETS}" --dbtype 1 ${THREAD_COMP_PAR} \
+                || fail "targets createdb died"
+        fi
+    else
+        # shellcheck disable=SC2086
+        "$MMSEQS" createdb "${USER_INPUT_TARGETS}" "${TMP_PATH}/targets" --dbtype 1 ${THREAD_COMP_PAR} \
+                || fail "targets createdb died"
+        INPUT_TARGETS="${TMP_PATH}/targets"
+    fi
 else
     # db exists!
     INPUT_TARGETS="${USER_INPUT_TARGETS}"
@@ -64,14 +80,14 @@ fi
 # reduce redundancy
 if notExists "${TMP_PATH}/MetaEuk_preds.dbtype"; then
     # shellcheck disable=SC2086
-    "$MMSEQS" reduceredundancy "${TMP_PATH}/MetaEuk_calls" "${TMP_PATH}/MetaEuk_preds" "${TMP_PATH}/MetaEuk_preds_clust" ${REDUCEREDUNDANCY_PAR} \
+    $RUNNER "$MMSEQS" reduceredundancy "${TMP_PATH}/MetaEuk_calls" "${TMP_PATH}/MetaEuk_preds" "${TMP_PATH}/MetaEuk_preds_clust" ${REDUCEREDUNDANCY_PAR} \
         || fail "reduceredundancy step died"
 fi
 
 # create fasta
 if notExists "$3"; then
     # shellcheck disable=SC2086
-    "$MMSEQS" unitesetstofasta "${INPUT_CONTIGS}" "${INPUT_TARGETS}" "${TMP_PATH}/MetaEuk_preds" "$3" ${UNITESETSTOFASTA_PAR} \
+    $RUNNER "$MMSEQS" unitesetstofasta "${INPUT_CONTIGS}" "${INPUT_TARGETS}" "${TMP_PATH}/MetaEuk_preds" "$3" ${UNITESETSTOFASTA_PAR} \
         || fail "unitesetstofasta step died"
 fi
 
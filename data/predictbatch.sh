@@ -0,0 +1,88 @@
+#!/bin/sh -e
+
+# predict batch workflow script
+fail() {
+    echo "Error: $1"
+    exit 1
+}
+
+notExists() {
+    [ ! -f "$1" ]
+}
+# check number of input variables
+[ "$#" -lt 1 ] && echo "Please provide <i:contigsDB1> ... <i:contigsDBN> <i:targetsDB> <o:predictionsBasename> <tmpDir>" && exit 1;
+[   -f "${RESULTS}_samples.tsv" ] && echo "${RESULTS}_samples.tsv exists already!" && exit 1;
+[ ! -d "${TMP_PATH}" ] && echo "tmp directory ${TMP_PATH} not found!" && mkdir -p "${TMP_PATH}";
+
+# concatenate the contigs of all samples, the keys of each sample are shifted by its offset in contigs.samples
+if notExists "${TMP_PATH}/contigs.dbtype"; then
+    # shellcheck disable=SC2086
+    "$MMSEQS" concatcontigs "$@" "${TMP_PATH}/contigs" ${CONCATCONTIGS_PAR} \
+        || fail "concatcontigs step died"
+fi
+
+# produce MetaEuk calls of all samples by a single predictexons
+if notExists "${TMP_PATH}/MetaEuk_calls.dbtype"; then
+    # shellcheck disable=SC2086
+    "$MMSEQS" predictexons "${TMP_PATH}/contigs" "${INPUT_TARGETS}" "${TMP_PATH}/MetaEuk_calls" "${TMP_PATH}/tmp_predict" ${PREDICTEXONS_PAR} \
+        || fail "predictexons step died"
+fi
+
+# reduce redundancy
+if notExists "${TMP_PATH}/MetaEuk_preds.dbtype"; then
+    # shellcheck disable=SC2086
+    $RUNNER "$MMSEQS" reduceredundancy "${TMP_PATH}/MetaEuk_calls" "${TMP_PATH}/MetaEuk_preds" "${TMP_PATH}/MetaEuk_preds_clust" ${REDUCEREDUNDANCY_PAR} \
+        || fail "reduceredundancy step died"
+fi
+
+# map each predicted contig key back to its sample and its original key
+if notExists "${TMP_PATH}/preds_map_done"; then
+    rm -f "${TMP_PATH}"/preds_map_*
+    awk -v prefix="${TMP_PATH}/preds_map_" 'FNR == NR { offset[$1] = $2; printf("") > (prefix $1); numSamples++; next; }
+        { sample = numSamples - 1; while (sample > 0 && offset[sample] > $1) { sample--; } print $1"\t"($1 - offset[sample]) > (prefix sample); }' \
+        "${TMP_PATH}/contigs.samples" "${TMP_PATH}/MetaEuk_preds.index" \
+        || fail "awk step died"
+    touch "${TMP_PATH}/preds_map_done"
+fi
+
+# demultiplex the predictions and create a fasta per sample
+NUM_SAMPLES=$(wc -l < "${TMP_PATH}/contigs.samples")
+SAMPLE=0
+while [ "${SAMPLE}" -lt "${NUM_SAMPLES}" ]; do
+    SAMPLE_CONTIGS="$(awk -F '\t' -v sample="${SAMPLE}" '$1 == sample { print $3; }' "${TMP_PATH}/contigs.samples")"
+    if notExists "${TMP_PATH}/MetaEuk_preds_${SAMPLE}.dbtype"; then
+        # shellcheck disable=SC2086
+        "$MMSEQS" renamedbkeys "${TMP_PATH}/preds_map_${SAMPLE}" "${TMP_PATH}/MetaEuk_preds" "${TMP_PATH}/MetaEuk_preds_${SAMPLE}" --subdb-mode 1 ${VERBOSITY_PAR} \
+            || fail "renamedbkeys step died"
+    fi
+    if notExists "${RESULTS}_${SAMPLE}.fas"; then
+        # shellcheck disable=SC2086
+        $RUNNER "$MMSEQS" unitesetstofasta "${SAMPLE_CONTIGS}" "${INPUT_TARGETS}" "${TMP_PATH}/MetaEuk_preds_${SAMPLE}" "${RESULTS}_${SAMPLE}" ${UNITESETSTOFASTA_PAR} \
+            || fail "unitesetstofasta step died"
+    fi
+    SAMPLE=$((SAMPLE+1))
+done
+
+# list which output belongs to which sample
+cut -f1,3 "${TMP_PATH}/contigs.samples" > "${RESULTS}_samples.tsv" \
+    || fail "cut step died"
+
+if [ -n "$REMOVE_TMP" ]; then
+    echo "Removing temporary files from ${TMP_PATH}"
+    SAMPLE=0
+    while [ "${SAMPLE}" -lt "${NUM_SAMPLES}" ]; do
+        "$MMSEQS" rmdb "${TMP_PATH}/MetaEuk_preds_${SAMPLE}"
+        # the soft linked split data leaves an empty data file behind
+        rm -f "${TMP_PATH}/MetaEuk_preds_${SAMPLE}" "${TMP_PATH}/preds_map_${SAMPLE}"
+        SAMPLE=$((SAMPLE+1))
+    done
+    rm -f "${TMP_PATH}/preds_map_done"
+    "$MMSEQS" rmdb "${TMP_PATH}/contigs"
+    "$MMSEQS" rmdb "${TMP_PATH}/contigs_h"
+    rm -f "${TMP_PATH}/contigs.samples"
+    "$MMSEQS" rmdb "${TMP_PATH}/MetaEuk_calls"
+    "$MMSEQS" rmdb "${TMP_PATH}/MetaEuk_preds"
+    "$MMSEQS" rmdb "${TMP_PATH}/MetaEuk_preds_clust"
+    rm -r "${TMP_PATH}/tmp_predict"
+    rm -f "${TMP_PATH}/predictbatch.sh"
+fi
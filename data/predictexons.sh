@@ -52,6 +52,16 @@ fi
 
 # when running in null mode (to assess evalues), reverse the AA fragments:
 AA_FRAGS="${TMP_PATH}/aa_6f"
+
+# only search the fragments that score as coding against the composition of the targets
+if [ -n "$FILTER_NONCODING" ]; then
+    if notExists "${AA_FRAGS}_coding.dbtype"; then
+        # shellcheck disable=SC2086
+        "$MMSEQS" filternoncoding "${AA_FRAGS}" "${INPUT_TARGETS}" "${AA_FRAGS}_coding" ${FILTERNONCODING_PAR} \
+            || fail "filternoncoding step died"
+    fi
+    AA_FRAGS="${AA_FRAGS}_coding"
+fi
 if [ -n "$REVERSE_FRAGMENTS" ]; then
     if notExists "${AA_FRAGS}_reverse.dbtype"; then
         # shellcheck disable=SC2086
@@ -62,7 +72,92 @@ if [ -n "$REVERSE_FRAGMENTS" ]; then
     echo "Will base search on ${AA_FRAGS}"
 fi
 
+# build the prefilter index of the targets once, later runs against the same targets map it
+# indexdb only rebuilds an existing index if it is incompatible with the search parameters
+if [ -n "$CREATE_TARGET_INDEX" ]; then
+    # shellcheck disable=SC2086
+    "$MMSEQS" indexdb "${INPUT_TARGETS}" "${INPUT_TARGETS}" ${INDEXDB_PAR} \
+        || fail "indexdb step died"
+fi
+if [ -f "${INPUT_TARGETS}.idx.dbtype" ]; then
+    echo "Will search against the target index ${INPUT_TARGETS}.idx"
+fi
+
 # search with each aa fragment ("stop-to-stop" orf) against a target DB
+if [ -n "${FAST_SEARCH_PAR}" ] && notExists "${TMP_PATH}/search_res.dbtype"; then
+    # a fast pass searches all fragments first, the fragments that are not part of an optimal set but lie on
+    # the contig region of one, or at most an intron away from it, are searched again with full sensitivity
+    # all other fragments keep the hits of the fast pass
+    if notExists "${TMP_PATH}/search_res_fast.dbtype"; then
+        # shellcheck disable=SC2086
+        "$MMSEQS" search "${AA_FRAGS}" "${INPUT_TARGETS}" "${TMP_PATH}/search_res_fast" "${TMP_PATH}/tmp_search_fast" ${FAST_SEARCH_PAR} \
+            || fail "fast search step died"
+    fi
+
+    if notExists "${TMP_PATH}/search_res_fast_by_contig.dbtype"; then
+        # shellcheck disable=SC2086
+        "$MMSEQS" resultspercontig "${INPUT_CONTIGS}" "${TMP_PATH}/nucl_6f" "${TMP_PATH}/search_res_fast" "${TMP_PATH}/search_res_fast_by_contig" ${THREAD_COMP_PAR} \
+            || fail "fast resultspercontig step died"
+    fi
+
+    if notExists "${TMP_PATH}/dp_predictions_fast.dbtype"; then
+        # shellcheck disable=SC2086
+        $RUNNER "$MMSEQS" collectoptimalset "${TMP_PATH}/search_res_fast_by_contig" "${INPUT_TARGETS}" "${TMP_PATH}/dp_predictions_fast" ${COLLECTOPTIMALSET_PAR} \
+            || fail "fast collectoptimalset step died"
+    fi
+
+    if notExists "${TMP_PATH}/fragments_full.dbtype"; then
+        # optimal set records prefixed with their contig key: the 7th and 8th column are the contig region of the set,
+        # the 9th column is the key of the fragment of the exon
+        # shellcheck disable=SC2086
+        "$MMSEQS" prefixid "${TMP_PATH}/dp_predictions_fast" "${TMP_PATH}/dp_predictions_fast.tsv" --tsv ${VERBOSITY_PAR} \
+            || fail "prefixid step died"
+        # fragment headers prefixed with the fragment key: contig key and start+length (or start-length on the minus strand)
+        # shellcheck disable=SC2086
+        "$MMSEQS" prefixid "${TMP_PATH}/nucl_6f_h" "${TMP_PATH}/fragments_loc.tsv" --tsv ${VERBOSITY_PAR} \
+            || fail "prefixid step died"
+        awk -v maxIntron="${MAX_INTRON}" 'FILENAME == ARGV[1] { chained[$9] = 1; n = ++sets[$1]; low[$1, n] = $7; high[$1, n] = $8; next }
+            FILENAME == ARGV[2] { searched[$1] = 1; next }
+            ($1 in searched) && !($1 in chained) && ($2 in sets) {
+                split($3, loc, /[+-]/);
+                from = loc[1]; to = index($3, "+") ? loc[1] + loc[2] : loc[1] - loc[2];
+                if (from > to) { tmp = from; from = to; to = tmp; }
+                for (i = 1; i <= sets[$2]; i++) {
+                    if (from <= high[$2, i] + maxIntron && to + maxIntron >= low[$2, i]) { print $1; break; }
+                }
+            }' "${TMP_PATH}/dp_predictions_fast.tsv" "${AA_FRAGS}.index" "${TMP_PATH}/fragments_loc.tsv" | sort -n > "${TMP_PATH}/fragments_full.list" \
+            || fail "full fragments step died"
+        awk 'FILENAME == ARGV[1] { full[$1] = 1; next } !($1 in full) { print $1 }' "${TMP_PATH}/fragments_full.list" "${AA_FRAGS}.index" > "${TMP_PATH}/fragments_fast.list" \
+            || fail "fast fragments step died"
+        # shellcheck disable=SC2086
+        "$MMSEQS" createsubdb "${TMP_PATH}/fragments_full.list" "${AA_FRAGS}" "${TMP_PATH}/fragments_full" ${VERBOSITY_PAR} --subdb-mode 1 \
+            || fail "createsubdb step died"
+    fi
+
+    if [ ! -s "${TMP_PATH}/fragments_full.index" ]; then
+        # shellcheck disable=SC2086
+        "$MMSEQS" mvdb "${TMP_PATH}/search_res_fast" "${TMP_PATH}/search_res" ${VERBOSITY_PAR} \
+            || fail "mvdb step died"
+    else
+        if notExists "${TMP_PATH}/search_res_full.dbtype"; then
+            # shellcheck disable=SC2086
+            "$MMSEQS" search "${TMP_PATH}/fragments_full" "${INPUT_TARGETS}" "${TMP_PATH}/search_res_full" "${TMP_PATH}/tmp_search" ${SEARCH_PAR} \
+                || fail "search step died"
+        fi
+
+        if notExists "${TMP_PATH}/search_res_kept.dbtype"; then
+            # shellcheck disable=SC2086
+            "$MMSEQS" createsubdb "${TMP_PATH}/fragments_fast.list" "${TMP_PATH}/search_res_fast" "${TMP_PATH}/search_res_kept" ${VERBOSITY_PAR} --subdb-mode 1 \
+                || fail "createsubdb step died"
+        fi
+
+        # the fragments of both passes are disjoint, so every fragment gets the hits of exactly one pass
+        # shellcheck disable=SC2086
+        "$MMSEQS" mergedbs "${AA_FRAGS}" "${TMP_PATH}/search_res" "${TMP_PATH}/search_res_kept" "${TMP_PATH}/search_res_full" ${VERBOSITY_COMP_PAR} \
+            || fail "mergedbs step died"
+    fi
+fi
+
 if notExists "${TMP_PATH}/search_res.dbtype"; then
     # shellcheck disable=SC2086
     "$MMSEQS" search "${AA_FRAGS}" "${INPUT_TARGETS}" "${TMP_PATH}/search_res" "${TMP_PATH}/tmp_search" ${SEARCH_PAR} \
@@ -79,7 +174,7 @@ fi
 # for each target, with respect to each contig and each strand, find the optimal set of exons
 if notExists "${TMP_PATH}/dp_predictions.dbtype"; then
     # shellcheck disable=SC2086
-    "$MMSEQS" collectoptimalset "${TMP_PATH}/search_res_by_contig" "${INPUT_TARGETS}" "${TMP_PATH}/dp_predictions" ${COLLECTOPTIMALSET_PAR} \
+    $RUNNER "$MMSEQS" collectoptimalset "${TMP_PATH}/search_res_by_contig" "${INPUT_TARGETS}" "${TMP_PATH}/dp_predictions" ${COLLECTOPTIMALSET_PAR} \
         || fail "collectoptimalset step died"
 fi
 
@@ -91,7 +186,9 @@ if [ -n "$REMOVE_TMP" ]; then
     rm -f "${TMP_PATH}"/nucl_6f*
     rm -f "${TMP_PATH}"/aa_6f*
     rm -f "${TMP_PATH}"/search_res*
-    rm -r "${TMP_PATH}/tmp_search"
+    rm -f "${TMP_PATH}"/fragments_*
+    rm -f "${TMP_PATH}"/dp_predictions_fast*
+    rm -rf "${TMP_PATH}/tmp_search" "${TMP_PATH}/tmp_search_fast"
     rm -f "${TMP_PATH}/predictexons.sh"
 fi
 
@@ -21,6 +21,15 @@ TAX_TARGET_DB="$4"
 TAX_ASSIGNMENT_BASENAME="$5"
 TMP_PATH="$6"
 
+# build the binary taxonomy image once, so every taxonomy step maps it instead of parsing the NCBI dumps
+if notExists "${TAX_TARGET_DB}_taxonomy" && [ -f "${TAX_TARGET_DB}_nodes.dmp" ]; then
+    # write to a process-specific name first, concurrent samples may race on the same target DB
+    # shellcheck disable=SC2086
+    "$MMSEQS" createbintaxonomy "${TAX_TARGET_DB}_names.dmp" "${TAX_TARGET_DB}_nodes.dmp" "${TAX_TARGET_DB}_merged.dmp" "${TAX_TARGET_DB}_taxonomy.$$" \
+        && mv -f "${TAX_TARGET_DB}_taxonomy.$$" "${TAX_TARGET_DB}_taxonomy" \
+        || { rm -f "${TAX_TARGET_DB}_taxonomy.$$"; echo "Could not write ${TAX_TARGET_DB}_taxonomy, taxonomy will be loaded from the NCBI dumps"; }
+fi
+
 # convert fasta to db
 if notExists "${TMP_PATH}/preds.dbtype"; then
     # shellcheck disable=SC2086
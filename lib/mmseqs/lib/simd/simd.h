@@ -66,6 +66,8 @@ typedef __m512d simd_double;
 #define simdf64_max(x,y)    _mm512_max_pd(x,y)
 #define simdf64_load(x)     _mm512_load_pd(x)
 #define simdf64_store(x,y)  _mm512_store_pd(x,y)
+#define simdf64_loadu(x)    _mm512_loadu_pd(x)
+#define simdf64_storeu(x,y) _mm512_storeu_pd(x,y)
 #define simdf64_set(x)      _mm512_set1_pd(x)
 #define simdf64_setzero(x)  _mm512_setzero_pd()
 #define simdf64_gt(x,y)     _mm512_cmpnle_pd_mask(x,y)
@@ -280,6 +282,8 @@ typedef __m256d simd_double;
 #define simdf64_max(x,y)    _mm256_max_pd(x,y)
 #define simdf64_load(x)     _mm256_load_pd(x)
 #define simdf64_store(x,y)  _mm256_store_pd(x,y)
+#define simdf64_loadu(x)    _mm256_loadu_pd(x)
+#define simdf64_storeu(x,y) _mm256_storeu_pd(x,y)
 #define simdf64_set(x)      _mm256_set1_pd(x)
 #define simdf64_setzero(x)  _mm256_setzero_pd()
 #define simdf64_gt(x,y)     _mm256_cmp_pd(x,y,_CMP_GT_OS)
@@ -345,6 +349,8 @@ typedef __m128d simd_double;
 #define simdf64_max(x,y)    _mm_max_pd(x,y)
 #define simdf64_load(x)     _mm_load_pd(x)
 #define simdf64_store(x,y)  _mm_store_pd(x,y)
+#define simdf64_loadu(x)    _mm_loadu_pd(x)
+#define simdf64_storeu(x,y) _mm_storeu_pd(x,y)
 #define simdf64_set(x)      _mm_set1_pd(x)
 #define simdf64_setzero(x)  _mm_setzero_pd()
 #define simdf64_gt(x,y)     _mm_cmpgt_pd(x,y)
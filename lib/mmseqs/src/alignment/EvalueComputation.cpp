@@ -0,0 +1,90 @@
+// include xxhash early to avoid incompatibilites with SIMDe
+#define XXH_INLINE_ALL
+#include "xxhash.h"
+
+#include "EvalueComputation.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+std::string EvalueComputation::getParameterCacheFile() {
+    const char *cacheFile = getenv("MMSEQS_EVALUE_CACHE");
+    if (cacheFile == NULL) {
+        return "";
+    }
+    return cacheFile;
+}
+
+std::string EvalueComputation::getParameterCacheKey(BaseMatrix *subMat, int gapOpen, int gapExtend, bool isGapped) {
+    std::vector<double> matrix;
+    matrix.reserve(1 + subMat->alphabetSize * (subMat->alphabetSize + 1));
+    matrix.push_back(subMat->alphabetSize);
+    for (int i = 0; i < subMat->alphabetSize; i++) {
+        for (int j = 0; j < subMat->alphabetSize; j++) {
+            matrix.push_back(subMat->subMatrix[i][j]);
+        }
+    }
+    for (int i = 0; i < subMat->alphabetSize; i++) {
+        matrix.push_back(subMat->pBack[i]);
+    }
+    const XXH64_hash_t matrixHash = XXH64(matrix.data(), matrix.size() * sizeof(double), 0);
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%016llx\t%d\t%d\t%d", (unsigned long long) matrixHash, isGapped, gapOpen, gapExtend);
+    return buffer;
+}
+
+bool EvalueComputation::readCachedParameters(const std::string &cacheFile, const std::string &key, Sls::AlignmentEvaluerParameters &par) {
+    FILE *handle = fopen(cacheFile.c_str(), "r");
+    if (handle == NULL) {
+        return false;
+    }
+    bool found = false;
+    char line[4096];
+    while (found == false && fgets(line, sizeof(line), handle) != NULL) {
+        if (strncmp(line, key.c_str(), key.size()) != 0 || line[key.size()] != '\t') {
+            continue;
+        }
+        // skip a last line cut short by an interrupted writer
+        size_t length = strlen(line);
+        if (length == 0 || line[length - 1] != '\n') {
+            continue;
+        }
+        found = sscanf(line + key.size(), "%lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf",
+                       &par.d_lambda, &par.d_k, &par.d_a1, &par.d_b1, &par.d_a2, &par.d_b2,
+                       &par.d_alpha1, &par.d_beta1, &par.d_alpha2, &par.d_beta2, &par.d_sigma, &par.d_tau) == 12
+                && par.d_lambda > 0 && par.d_k > 0;
+    }
+    fclose(handle);
+    return found;
+}
+
+void EvalueComputation::writeCachedParameters(const std::string &cacheFile, const std::string &key, const Sls::AlignmentEvaluerParameters &par) {
+    int fd = open(cacheFile.c_str(), O_RDWR | O_APPEND | O_CREAT, 0666);
+    if (fd == -1) {
+        Debug(Debug::INFO) << "Could not open E-value parameter cache " << cacheFile << "\n";
+        return;
+    }
+    // concurrent processes append one after the other
+    if (flock(fd, LOCK_EX) != 0) {
+        Debug(Debug::INFO) << "Could not lock E-value parameter cache " << cacheFile << "\n";
+        close(fd);
+        return;
+    }
+    // start on a new line if the last entry was cut short
+    bool needsNewline = false;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        char last;
+        needsNewline = pread(fd, &last, 1, st.st_size - 1) != 1 || last != '\n';
+    }
+    char buffer[1024];
+    int length = snprintf(buffer, sizeof(buffer), "%s%s\t%.17g\t%.17g\t%.17g\t%.17g\t%.17g\t%.17g\t%.17g\t%.17g\t%.17g\t%.17g\t%.17g\t%.17g\n",
+                          needsNewline ? "\n" : "", key.c_str(), par.d_lambda, par.d_k, par.d_a1, par.d_b1, par.d_a2, par.d_b2,
+                          par.d_alpha1, par.d_beta1, par.d_alpha2, par.d_beta2, par.d_sigma, par.d_tau);
+    if (write(fd, buffer, length) != length) {
+        Debug(Debug::INFO) << "Could not add E-value parameters to cache " << cacheFile << "\n";
+    }
+    flock(fd, LOCK_UN);
+    close(fd);
+}
@@ -67,6 +67,66 @@ private:
                                                        30.455610143099914211, -622.28684628915891608,
                                                        30.455610143099914211, -622.28684628915891608,
                                                        29.602444874818868215, -601.81087985041381216}},
+                {"blosum62.out", 13, 1, true,  {0.29698584559723795184, 0.082909438655904443838,
+                                                       1.1736466603182713619, -11.520190413733896406,
+                                                       1.1736466603182713619, -11.520190413733896406,
+                                                       15.328428349754261717, -302.44023045700703278,
+                                                       15.328428349754261717, -302.44023045700703278,
+                                                       15.01172783728511817, -293.57261610787099926}},
+                {"blosum62.out", 12, 1, true,  {0.28670379424350223019, 0.066537964256939516328,
+                                                       1.3209897626110178592, -14.528240329507170259,
+                                                       1.3209897626110178592, -14.528240329507170259,
+                                                       18.901211359067211504, -373.72971509507181054,
+                                                       18.901211359067211504, -373.72971509507181054,
+                                                       18.441877078381164523, -361.78702379723455351}},
+                {"blosum62.out", 10, 1, true,  {0.25268120083384587593, 0.030136802276522055982,
+                                                       2.1287352075023013853, -30.06352622026815169,
+                                                       2.1287352075023013853, -30.06352622026815169,
+                                                       56.246590827638115684, -1137.8311841582360557,
+                                                       56.246590827638115684, -1137.8311841582360557,
+                                                       54.748265481143981503, -1104.8680265353650611}},
+                {"blosum62.out", 9, 1, true,  {0.21879482151584905836, 0.014293432544581419902,
+                                                       3.351960218153416271, -51.794978595084245399,
+                                                       3.351960218153416271, -51.794978595084245399,
+                                                       156.38330857802452556, -3037.1263406061243586,
+                                                       156.38330857802452556, -3037.1263406061243586,
+                                                       153.4067107457768202, -2977.5943839611704789}},
+                {"blosum62.out", 11, 2, true,  {0.30412902405787733962, 0.096299204313727196358,
+                                                       0.950723557753046844, -4.9013190031999247509,
+                                                       0.950723557753046844, -4.9013190031999247509,
+                                                       7.1222207402688635369, -67.47595900631472432,
+                                                       7.1222207402688635369, -67.47595900631472432,
+                                                       7.0567206095836958468, -65.77295560850036793}},
+                {"blosum62.out", 10, 2, true,  {0.29637259827614337304, 0.08295024473030304657,
+                                                       1.0605834488121899106, -7.1609318499116714207,
+                                                       1.0605834488121899106, -7.1609318499116714207,
+                                                       10.46123260131972188, -142.42178528643418645,
+                                                       10.46123260131972188, -142.42178528643418645,
+                                                       10.363342546271685052, -140.07242396528130257}},
+                {"blosum62.out", 9, 2, true,  {0.28779749397099452235, 0.069038236829045931953,
+                                                       1.2765699491851054681, -11.315890537289840623,
+                                                       1.2765699491851054681, -11.315890537289840623,
+                                                       17.26110971959709417, -280.1505997813335398,
+                                                       17.26110971959709417, -280.1505997813335398,
+                                                       17.144489934653478258, -277.58496451257400395}},
+                {"blosum62.out", 8, 2, true,  {0.26921621780494986442, 0.051702500472119196362,
+                                                       1.4830935745006843529, -14.41764572202961503,
+                                                       1.4830935745006843529, -14.41764572202961503,
+                                                       20.524581367395359877, -319.95179639354125811,
+                                                       20.524581367395359877, -319.95179639354125811,
+                                                       20.260317468775038918, -314.66651842113486737}},
+                {"blosum62.out", 7, 2, true,  {0.24849097312950441108, 0.033402813063519769254,
+                                                       1.9263211863681546365, -20.953978163441117744,
+                                                       1.9263211863681546365, -20.953978163441117744,
+                                                       41.049267883805903523, -657.40097404957691651,
+                                                       41.049267883805903523, -657.40097404957691651,
+                                                       40.456494772076183608, -646.73105803844191541}},
+                {"blosum62.out", 6, 2, true,  {0.20846387139719346759, 0.016060378629906533338,
+                                                       2.7983154619973502619, -32.577666777570343015,
+                                                       2.7983154619973502619, -32.577666777570343015,
+                                                       92.688358150998936935, -1410.5818656524902508,
+                                                       92.688358150998936935, -1410.5818656524902508,
+                                                       91.717552328232670789, -1395.0489724882299925}},
                 {"blosum62.out", 0,  0, false, {0.3207378152604042354,  0.13904657125294345166,
                                                        0.76221128839920349041, 0,
                                                        0.76221128839920349041, 0,
@@ -88,6 +148,20 @@ private:
             }
         }
 
+        // with MMSEQS_EVALUE_CACHE set, parameters of other configurations are computed once and then read from that file
+        std::string cacheFile;
+        std::string cacheKey;
+        Sls::AlignmentEvaluerParameters cachedPar;
+        if(par == NULL){
+            cacheFile = getParameterCacheFile();
+            if(cacheFile.empty() == false){
+                cacheKey = getParameterCacheKey(subMat, gapOpen, gapExtend, isGapped);
+                if(readCachedParameters(cacheFile, cacheKey, cachedPar)){
+                    par = &cachedPar;
+                }
+            }
+        }
+
         if(par!=NULL){
             evaluer.initParameters(*par);
         }else{
@@ -144,6 +218,16 @@ private:
             delete [] tmpMatData;
             delete [] tmpMat;
 
+            if(cacheFile.empty() == false && evaluer.isGood()){
+                // continue from the stored parameters, so that the E-values do not depend on whether the cache was hit
+                const Sls::ALP_set_of_parameters &alpPar = evaluer.parameters();
+                Sls::AlignmentEvaluerParameters computedPar = {alpPar.lambda, alpPar.K,
+                                                              alpPar.a_J, alpPar.b_J, alpPar.a_I, alpPar.b_I,
+                                                              alpPar.alpha_J, alpPar.beta_J, alpPar.alpha_I, alpPar.beta_I,
+                                                              alpPar.sigma, alpPar.tau};
+                writeCachedParameters(cacheFile, cacheKey, computedPar);
+                evaluer.initParameters(computedPar);
+            }
         }
         if(evaluer.isGood()==false){
             Debug(Debug::ERROR) << "ALP did not converge for the substitution matrix, gap open, gap extend input.\n"
@@ -153,6 +237,13 @@ private:
         logK = log(evaluer.parameters().K);
     }
 
+    // path of the cache from MMSEQS_EVALUE_CACHE, empty if it is not set
+    static std::string getParameterCacheFile();
+    // the cache is keyed by the scores and background frequencies of the matrix, not its name
+    static std::string getParameterCacheKey(BaseMatrix *subMat, int gapOpen, int gapExtend, bool isGapped);
+    static bool readCachedParameters(const std::string &cacheFile, const std::string &key, Sls::AlignmentEvaluerParameters &par);
+    static void writeCachedParameters(const std::string &cacheFile, const std::string &key, const Sls::AlignmentEvaluerParameters &par);
+
     Sls::AlignmentEvaluer evaluer;
     const size_t dbResCount;
     double logK;
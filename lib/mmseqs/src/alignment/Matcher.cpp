@@ -208,6 +208,64 @@ float Matcher::estimateSeqIdByScorePerCol(uint16_t score, unsigned int qLen, uns
     return std::max(0.0f, estimatedSeqId);
 }
 
+void Matcher::parseAlignmentRecord(const char *data, unsigned int columnMask, result_view_t &view) {
+    const char *entry[255];
+    size_t columns = Util::getWordsOfLine(data, entry, 255);
+    if (columns < ALN_RES_WITHOUT_BT_COL_CNT) {
+        Debug(Debug::ERROR) << "Invalid alignment result record.\n";
+        EXIT(EXIT_FAILURE);
+    }
+    view.columns = columns;
+    view.record = data;
+    view.recordLength = (entry[9] + Util::skipNoneWhitespace(entry[9])) - data;
+
+    switch (columns) {
+        case ALN_RES_WITHOUT_BT_COL_CNT:
+        case ALN_RES_WITH_ORF_POS_WITHOUT_BT_COL_CNT:
+            view.backtrace = NULL;
+            view.backtraceLength = 0;
+            break;
+        case ALN_RES_WITH_BT_COL_CNT:
+        case ALN_RES_WITH_ORF_AND_BT_COL_CNT:
+            view.backtrace = entry[columns - 1];
+            view.backtraceLength = entry[columns] - entry[columns - 1];
+            break;
+        default:
+            Debug(Debug::ERROR) << "Invalid column count in alignment.\n";
+            EXIT(EXIT_FAILURE);
+    }
+
+    if (columnMask & COLUMN_KEY) {
+        view.dbKey = Util::fast_atoi<unsigned int>(data);
+    }
+    if (columnMask & COLUMN_SCORE) {
+        view.score = Util::fast_atoi<int>(entry[1]);
+    }
+    if (columnMask & COLUMN_SEQID) {
+        view.seqId = strtod(entry[2], NULL);
+    }
+    if (columnMask & COLUMN_EVAL) {
+        view.eval = strtod(entry[3], NULL);
+    }
+    if (columnMask & COLUMN_QUERY_POS) {
+        view.qStartPos = Util::fast_atoi<int>(entry[4]);
+        view.qEndPos = Util::fast_atoi<int>(entry[5]);
+        view.qLen = Util::fast_atoi<unsigned int>(entry[6]);
+    }
+    if (columnMask & COLUMN_TARGET_POS) {
+        view.dbStartPos = Util::fast_atoi<int>(entry[7]);
+        view.dbEndPos = Util::fast_atoi<int>(entry[8]);
+        view.dbLen = Util::fast_atoi<unsigned int>(entry[9]);
+    }
+    if (columnMask & COLUMN_ORF_POS) {
+        bool hasOrfPos = columns >= ALN_RES_WITH_ORF_POS_WITHOUT_BT_COL_CNT;
+        view.queryOrfStartPos = hasOrfPos ? Util::fast_atoi<int>(entry[10]) : -1;
+        view.queryOrfEndPos = hasOrfPos ? Util::fast_atoi<int>(entry[11]) : -1;
+        view.dbOrfStartPos = hasOrfPos ? Util::fast_atoi<int>(entry[12]) : -1;
+        view.dbOrfEndPos = hasOrfPos ? Util::fast_atoi<int>(entry[13]) : -1;
+    }
+}
+
 std::string Matcher::compressAlignment(const std::string& bt) {
     std::string ret;
     char state = 'M';
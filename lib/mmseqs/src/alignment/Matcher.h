@@ -29,6 +29,41 @@ public:
     const static int ALN_RES_WITH_ORF_POS_WITHOUT_BT_COL_CNT = 14;
     const static int ALN_RES_WITH_ORF_AND_BT_COL_CNT = 15;
 
+    // columns converted by the projected parseAlignmentRecord
+    static const unsigned int COLUMN_KEY        = 1 << 0;
+    static const unsigned int COLUMN_SCORE      = 1 << 1;
+    static const unsigned int COLUMN_SEQID      = 1 << 2;
+    static const unsigned int COLUMN_EVAL       = 1 << 3;
+    static const unsigned int COLUMN_QUERY_POS  = 1 << 4;
+    static const unsigned int COLUMN_TARGET_POS = 1 << 5;
+    static const unsigned int COLUMN_ORF_POS    = 1 << 6;
+    static const unsigned int COLUMN_ALL        = (1 << 7) - 1;
+
+    // alignment record with only the requested columns converted, the backtrace is not copied
+    struct result_view_t {
+        unsigned int dbKey;
+        int score;
+        float seqId;
+        double eval;
+        int qStartPos;
+        int qEndPos;
+        unsigned int qLen;
+        int dbStartPos;
+        int dbEndPos;
+        unsigned int dbLen;
+        int queryOrfStartPos;
+        int queryOrfEndPos;
+        int dbOrfStartPos;
+        int dbOrfEndPos;
+        // the record text up to the end of the ten alignment columns
+        const char *record;
+        unsigned int recordLength;
+        // the compressed backtrace as stored in the record, NULL without a backtrace
+        const char *backtrace;
+        unsigned int backtraceLength;
+        unsigned int columns;
+    };
+
     struct result_t {
         unsigned int dbKey;
         int score;
@@ -206,6 +241,8 @@ public:
 
     static result_t parseAlignmentRecord(const char *data, bool readCompressed=false);
 
+    static void parseAlignmentRecord(const char *data, unsigned int columnMask, result_view_t &view);
+
     static void readAlignmentResults(std::vector<result_t> &result, char *data, bool readCompressed = false);
 
     static float estimateSeqIdByScorePerCol(uint16_t score, unsigned int qLen, unsigned int tLen);
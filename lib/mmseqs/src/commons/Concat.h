@@ -14,6 +14,12 @@
 #include <algorithm>
 #include <fcntl.h>
 #include <limits.h>
+#include <errno.h>
+#include <vector>
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
 
 #include "Debug.h"
 #include "Util.h"
@@ -144,6 +150,167 @@ public:
     }
 
 
+    // writes every file at the sum of the sizes of the files before it, so that the files are copied in parallel
+    // into a preallocated output instead of appending them one after another
+    // with alignFiles, files start at block boundaries if the filesystem can share blocks between files (reflinks),
+    // so that all their full blocks are cloned instead of copied and the gaps read as null bytes
+    // with requireFastCopy, nothing is written and no offsets are returned if the first file can neither be cloned
+    // nor copied in the kernel, the caller then keeps the files apart instead of copying every byte through user space
+    // returns the offset of each file in the output
+    static std::vector<size_t> concatFilesAt(const std::vector<FILE*> &files, const std::vector<size_t> &sizes, FILE *outFile,
+                                             bool alignFiles, bool requireFastCopy) {
+        int output_desc = fileno(outFile);
+        struct stat out_stat;
+        if (fstat(output_desc, &out_stat) < 0) {
+            Debug(Debug::ERROR) << "Error with output file\n";
+            EXIT(EXIT_FAILURE);
+        }
+        const size_t blockSize = out_stat.st_blksize;
+        // the first file is cloned or copied in the kernel to offset 0 of the still empty output
+        // to find out which of the fast paths work
+        bool firstCloned = false;
+        bool firstCopied = false;
+        if (files.size() > 1 && sizes[0] > 0) {
+            if (alignFiles && blockSize > 0) {
+                firstCloned = cloneRange(fileno(files[0]), output_desc, 0, sizes[0]);
+            }
+            firstCopied = firstCloned || copyRangeInKernel(fileno(files[0]), output_desc, 0, 0, sizes[0]) == sizes[0];
+        }
+        if (requireFastCopy && firstCopied == false) {
+            return std::vector<size_t>();
+        }
+        std::vector<size_t> offsets(files.size() + 1, 0);
+        for (size_t fileIdx = 0; fileIdx < files.size(); fileIdx++) {
+            offsets[fileIdx + 1] = offsets[fileIdx] + sizes[fileIdx];
+            if (firstCloned && fileIdx + 1 < files.size()) {
+                offsets[fileIdx + 1] = (offsets[fileIdx + 1] + blockSize - 1) / blockSize * blockSize;
+            }
+        }
+        const size_t totalSize = offsets[files.size()];
+#if HAVE_FALLOCATE
+        // reserve the blocks up front, filesystems without support are still extended by ftruncate
+        // cloned blocks are shared with the input files and need no reservation
+        if (totalSize > 0 && firstCloned == false && fallocate(output_desc, 0, 0, totalSize) != 0) {
+            if (errno == ENOSPC) {
+                Debug(Debug::ERROR) << "Not enough disk space to merge " << totalSize << " bytes into the output file\n";
+                EXIT(EXIT_FAILURE);
+            }
+        }
+#endif
+        if (ftruncate(output_desc, totalSize) != 0) {
+            Debug(Debug::ERROR) << "Cannot resize output file to " << totalSize << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+
+        bool success = true;
+#pragma omp parallel for schedule(dynamic, 1) reduction(&&: success)
+        for (size_t fileIdx = (firstCopied ? 1 : 0); fileIdx < files.size(); fileIdx++) {
+            int input_desc = fileno(files[fileIdx]);
+            struct stat stat_buf;
+            if (fstat(input_desc, &stat_buf) < 0) {
+                success = false;
+                continue;
+            }
+            size_t bufsize = io_blksize(stat_buf);
+            char *buf = (char *) mem_align(getpagesize(), bufsize);
+#if HAVE_POSIX_FADVISE
+            posix_fadvise(input_desc, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+            success = success && copyToOffset(input_desc, output_desc, offsets[fileIdx], sizes[fileIdx], firstCloned ? blockSize : 0, buf, bufsize);
+            free(buf);
+        }
+        if (success == false) {
+            Debug(Debug::ERROR) << "Cannot copy file into merged output\n";
+            EXIT(EXIT_FAILURE);
+        }
+        offsets.pop_back();
+        return offsets;
+    }
+
+    // shares size bytes from the start of input_desc with out_desc at outOffset
+    // the filesystem needs block aligned offsets and a block aligned size, unless the range ends at the end of both files
+    static bool cloneRange(int input_desc, int out_desc, size_t outOffset, size_t size) {
+#ifdef FICLONERANGE
+        struct file_clone_range range;
+        range.src_fd = input_desc;
+        range.src_offset = 0;
+        range.src_length = size;
+        range.dest_offset = outOffset;
+        return ioctl(out_desc, FICLONERANGE, &range) == 0;
+#else
+        (void) input_desc;
+        (void) out_desc;
+        (void) outOffset;
+        (void) size;
+        return false;
+#endif
+    }
+
+    // copies size bytes from inOffset of input_desc to outOffset of out_desc with copy_file_range
+    // returns the number of bytes copied before the filesystems stopped supporting it
+    static size_t copyRangeInKernel(int input_desc, int out_desc, size_t inOffset, size_t outOffset, size_t size) {
+        size_t pos = 0;
+#if HAVE_COPY_FILE_RANGE
+        while (pos < size) {
+            loff_t inPos = inOffset + pos;
+            loff_t outPos = outOffset + pos;
+            ssize_t n_copied = copy_file_range(input_desc, &inPos, out_desc, &outPos, size - pos, 0);
+            if (n_copied < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n_copied <= 0) {
+                break;
+            }
+            pos += n_copied;
+        }
+#else
+        (void) input_desc;
+        (void) out_desc;
+        (void) inOffset;
+        (void) outOffset;
+        (void) size;
+#endif
+        return pos;
+    }
+
+    // copies the first size bytes of input_desc to out_desc at outOffset, the file offsets of both stay unchanged
+    // with a cloneBlockSize and a block aligned outOffset the full blocks are shared as reflinks,
+    // copy_file_range keeps the copy of the rest in the kernel and whatever it does not support is read and written through buf
+    static bool copyToOffset(int input_desc, int out_desc, size_t outOffset, size_t size, size_t cloneBlockSize, char *buf, size_t bufsize) {
+        size_t pos = 0;
+        if (cloneBlockSize > 0 && outOffset % cloneBlockSize == 0) {
+            const size_t cloneSize = size / cloneBlockSize * cloneBlockSize;
+            if (cloneSize > 0 && cloneRange(input_desc, out_desc, outOffset, cloneSize)) {
+                pos = cloneSize;
+            }
+        }
+        pos += copyRangeInKernel(input_desc, out_desc, pos, outOffset + pos, size - pos);
+        while (pos < size) {
+            ssize_t n_read = pread(input_desc, buf, std::min(bufsize, size - pos), pos);
+            if (n_read < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n_read <= 0) {
+                Debug(Debug::ERROR) << "read error nr: " << errno << "\n";
+                return false;
+            }
+            ssize_t written = 0;
+            while (written < n_read) {
+                ssize_t n_written = pwrite(out_desc, buf + written, n_read - written, outOffset + pos + written);
+                if (n_written < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n_written <= 0) {
+                    Debug(Debug::ERROR) << "write error nr: " << errno << "\n";
+                    return false;
+                }
+                written += n_written;
+            }
+            pos += n_read;
+        }
+        return true;
+    }
+
     static bool doConcat(int input_desc, int out_desc, const char *buf, size_t bufsize) {
         while (true) {
             /* Read a block of input.  */
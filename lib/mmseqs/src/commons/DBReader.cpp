@@ -1,3 +1,7 @@
+// include xxhash early to avoid incompatibilites with SIMDe
+#define XXH_INLINE_ALL
+#include "xxhash.h"
+
 #include "DBReader.h"
 #include "FastSort.h"
 #include <algorithm>
@@ -27,7 +31,8 @@ threads(threads), dataMode(dataMode), dataFileName(strdup(dataFileName_)),
         indexFileName(strdup(indexFileName_)), size(0), dataFiles(NULL), dataSizeOffset(NULL), dataFileCnt(0),
         totalDataSize(0), dataSize(0), lastKey(T()), closed(1), dbtype(Parameters::DBTYPE_GENERIC_DB),
         compressedBuffers(NULL), compressedBufferSizes(NULL), index(NULL), id2local(NULL), local2id(NULL),
-        dataMapped(false), accessType(0), externalData(false), didMlock(false)
+        dataMapped(false), accessType(0), externalData(false), indexMapped(false), indexMappedSize(0), didMlock(false),
+        prefetchCursors(NULL), prefetchEnd(0), releasedEnd(0)
 {
     if (threads > 1) {
         FileUtil::fixRlimitNoFile();
@@ -40,7 +45,8 @@ DBReader<T>::DBReader(DBReader<T>::Index *index, size_t size, size_t dataSize, T
         threads(threads), dataMode(USE_INDEX), dataFileName(NULL), indexFileName(NULL),
         size(size), dataFiles(NULL), dataSizeOffset(NULL), dataFileCnt(0), totalDataSize(0), dataSize(dataSize), lastKey(lastKey),
         maxSeqLen(maxSeqLen), closed(1), dbtype(dbType), compressedBuffers(NULL), compressedBufferSizes(NULL), index(index), sortedByOffset(true),
-        id2local(NULL), local2id(NULL), dataMapped(false), accessType(NOSORT), externalData(true), didMlock(false)
+        id2local(NULL), local2id(NULL), dataMapped(false), accessType(NOSORT), externalData(true), indexMapped(false),
+        indexMappedSize(0), didMlock(false), prefetchCursors(NULL), prefetchEnd(0), releasedEnd(0)
 {}
 
 template <typename T>
@@ -161,21 +167,24 @@ template <typename T> bool DBReader<T>::open(int accessType){
     }
     bool isSortedById = false;
     if (externalData == false) {
-        MemoryMapped indexData(indexFileName, MemoryMapped::WholeFile, MemoryMapped::SequentialScan);
-        if (!indexData.isValid()){
-            Debug(Debug::ERROR) << "Cannot open index file " << indexFileName << "\n";
-            EXIT(EXIT_FAILURE);
-        }
-        char* indexDataChar = (char *) indexData.getData();
-        size_t indexDataSize = indexData.size();
-        size = Util::ompCountLines(indexDataChar, indexDataSize, threads);
+        bool isSortedById = true;
+        if (readBinaryIndex() == false) {
+            MemoryMapped indexData(indexFileName, MemoryMapped::WholeFile, MemoryMapped::SequentialScan);
+            if (!indexData.isValid()){
+                Debug(Debug::ERROR) << "Cannot open index file " << indexFileName << "\n";
+                EXIT(EXIT_FAILURE);
+            }
+            char* indexDataChar = (char *) indexData.getData();
+            size_t indexDataSize = indexData.size();
+            size = Util::ompCountLines(indexDataChar, indexDataSize, threads);
 
-        index = new(std::nothrow) Index[size];
-        Util::checkAllocation(index, "Cannot allocate index memory in DBReader");
-        incrementMemory(sizeof(Index) * size);
+            index = new(std::nothrow) Index[size];
+            Util::checkAllocation(index, "Cannot allocate index memory in DBReader");
+            incrementMemory(sizeof(Index) * size);
 
-        bool isSortedById = readIndex(indexDataChar, indexDataSize, index, dataSize);
-        indexData.close();
+            isSortedById = readIndex(indexDataChar, indexDataSize, index, dataSize);
+            indexData.close();
+        }
 
         // sortIndex also handles access modes that don't require sorting
         sortIndex(isSortedById);
@@ -188,6 +197,17 @@ template <typename T> bool DBReader<T>::open(int accessType){
         }
     }
 
+    // prefetching follows the offsets, random access would release data that is still needed
+    if ((dataMode & USE_PREFETCH) && (dataMode & USE_DATA) && (dataMode & USE_FREAD) == 0 && sortedByOffset && size > 0) {
+        // threads that did not start yet will receive entries behind the others and do not hold back the release
+        prefetchCursors = new std::atomic<size_t>[threads * PREFETCH_CURSOR_STRIDE];
+        for (size_t i = 0; i < threads * PREFETCH_CURSOR_STRIDE; ++i) {
+            prefetchCursors[i].store(SIZE_MAX, std::memory_order_relaxed);
+        }
+        prefetchEnd.store(0, std::memory_order_relaxed);
+        releasedEnd = 0;
+    }
+
     compression = isCompressed(dbtype);
     if(compression == COMPRESSED){
         compressedBufferSizes = new size_t[threads];
@@ -208,6 +228,14 @@ template <typename T> bool DBReader<T>::open(int accessType){
                 EXIT(EXIT_FAILURE);
             }
         }
+        dstreamDictIds = new unsigned int[threads];
+        std::fill(dstreamDictIds, dstreamDictIds + threads, 0);
+        if (dataFileName != NULL) {
+            std::string dictionaryFile = std::string(dataFileName) + ".dict";
+            if (FileUtil::fileExists(dictionaryFile.c_str())) {
+                readDictionaries(dictionaryFile);
+            }
+        }
     }
 
     closed = 0;
@@ -467,6 +495,11 @@ template <typename T> void DBReader<T>::remapData(){
 }
 
 template <typename T> void DBReader<T>::close(){
+    if (prefetchCursors != NULL) {
+        delete[] prefetchCursors;
+        prefetchCursors = NULL;
+    }
+
     if (dataMode & USE_LOOKUP || dataMode & USE_LOOKUP_REV) {
         delete[] lookup;
     }
@@ -493,9 +526,17 @@ template <typename T> void DBReader<T>::close(){
         delete [] compressedBuffers;
         delete [] compressedBufferSizes;
         delete [] dstream;
+        delete [] dstreamDictIds;
+        for (size_t i = 0; i < ddicts.size(); ++i) {
+            ZSTD_freeDDict(ddicts[i]);
+        }
+        ddicts.clear();
     }
 
-    if(externalData == false) {
+    if (indexMapped) {
+        FileUtil::munmapData(reinterpret_cast<char*>(index) - sizeof(BinaryIndexHeader), indexMappedSize);
+        indexMapped = false;
+    } else if (externalData == false) {
         delete[] index;
         decrementMemory(size*sizeof(Index));
     }
@@ -519,6 +560,35 @@ template <typename T> char* DBReader<T>::getDataCompressed(size_t id, int thrIdx
     const char *dataStart = data + sizeof(unsigned int);
     bool isCompressed = (dataStart[cSize] == 0) ? true : false;
     if(isCompressed){
+        // the stream of each thread keeps its dictionary, only reinitialize it when the frame needs another one
+        unsigned int dictId = ddicts.empty() ? 0 : ZSTD_getDictID_fromFrame(cBuff, cSize);
+        if (dictId == 0 && dstreamDictIds[thrIdx] != 0) {
+            // frames written before the dictionary was trained must not see its content or entropy tables
+            size_t initResult = ZSTD_initDStream(dstream[thrIdx]);
+            if (ZSTD_isError(initResult)) {
+                Debug(Debug::ERROR) << id << " ZSTD_initDStream " << ZSTD_getErrorName(initResult) << "\n";
+                EXIT(EXIT_FAILURE);
+            }
+            dstreamDictIds[thrIdx] = 0;
+        } else if (dictId != 0 && dictId != dstreamDictIds[thrIdx]) {
+            ZSTD_DDict* ddict = NULL;
+            for (size_t i = 0; i < ddicts.size(); ++i) {
+                if (ZSTD_getDictID_fromDDict(ddicts[i]) == dictId) {
+                    ddict = ddicts[i];
+                    break;
+                }
+            }
+            if (ddict == NULL) {
+                Debug(Debug::ERROR) << "Compression dictionary " << dictId << " of entry " << id << " not found in " << dataFileName << ".dict\n";
+                EXIT(EXIT_FAILURE);
+            }
+            size_t initResult = ZSTD_initDStream_usingDDict(dstream[thrIdx], ddict);
+            if (ZSTD_isError(initResult)) {
+                Debug(Debug::ERROR) << id << " ZSTD_initDStream_usingDDict " << ZSTD_getErrorName(initResult) << "\n";
+                EXIT(EXIT_FAILURE);
+            }
+            dstreamDictIds[thrIdx] = dictId;
+        }
         ZSTD_inBuffer input = {cBuff, cSize, 0};
         while (input.pos < input.size) {
             ZSTD_outBuffer output = {compressedBuffers[thrIdx], compressedBufferSizes[thrIdx], 0};
@@ -538,6 +608,126 @@ template <typename T> char* DBReader<T>::getDataCompressed(size_t id, int thrIdx
     return compressedBuffers[thrIdx];
 }
 
+template <typename T> void DBReader<T>::readDictionaries(const std::string &dictionaryFile) {
+    MemoryMapped dictionaryData(dictionaryFile, MemoryMapped::WholeFile, MemoryMapped::SequentialScan);
+    if (!dictionaryData.isValid()) {
+        Debug(Debug::ERROR) << "Cannot open dictionary file " << dictionaryFile << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+    const char* data = (const char*) dictionaryData.getData();
+    size_t dataSize = dictionaryData.size();
+    // the file lists [size][dictionary] records, merged databases carry one record per part
+    size_t pos = 0;
+    while (pos < dataSize) {
+        if (pos + sizeof(unsigned int) > dataSize) {
+            Debug(Debug::ERROR) << "Dictionary file " << dictionaryFile << " is truncated\n";
+            EXIT(EXIT_FAILURE);
+        }
+        unsigned int dictionarySize = *(reinterpret_cast<const unsigned int *>(data + pos));
+        pos += sizeof(unsigned int);
+        if (pos + dictionarySize > dataSize) {
+            Debug(Debug::ERROR) << "Dictionary file " << dictionaryFile << " is truncated\n";
+            EXIT(EXIT_FAILURE);
+        }
+        ZSTD_DDict* ddict = ZSTD_createDDict(data + pos, dictionarySize);
+        if (ddict == NULL) {
+            Debug(Debug::ERROR) << "ZSTD_createDDict() error for " << dictionaryFile << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+        pos += dictionarySize;
+
+        unsigned int dictId = ZSTD_getDictID_fromDDict(ddict);
+        bool isKnown = false;
+        for (size_t i = 0; i < ddicts.size(); ++i) {
+            isKnown |= (ZSTD_getDictID_fromDDict(ddicts[i]) == dictId);
+        }
+        if (isKnown) {
+            ZSTD_freeDDict(ddict);
+        } else {
+            ddicts.emplace_back(ddict);
+        }
+    }
+    dictionaryData.close();
+}
+
+template <typename T> bool DBReader<T>::readBinaryIndex() {
+    // only numeric keys have a binary index
+    return false;
+}
+
+template <> bool DBReader<unsigned int>::readBinaryIndex() {
+    std::string binaryIndexFile = std::string(indexFileName) + ".bin";
+    BinaryIndexHeader header;
+    uint64_t indexFileSize;
+    int64_t indexFileMtime;
+    if (FileUtil::fileExists(binaryIndexFile.c_str()) == false
+        || getIndexFileStamp(indexFileName, indexFileSize, indexFileMtime) == false) {
+        return false;
+    }
+
+    FILE* file = fopen(binaryIndexFile.c_str(), "r");
+    if (file == NULL) {
+        return false;
+    }
+    size_t fileSize = 0;
+    bool isValid = fread(&header, sizeof(BinaryIndexHeader), 1, file) == 1
+                   && header.magic == BinaryIndexHeader::MAGIC
+                   && header.version == BinaryIndexHeader::VERSION
+                   && header.entrySize == sizeof(Index)
+                   && header.indexFileSize == indexFileSize
+                   && header.indexFileMtime == indexFileMtime;
+    char* data = NULL;
+    if (isValid) {
+        // private mapping, sorting by offset and the offset shifts of mergeIndex may modify the entries
+        struct stat sb;
+        isValid = fstat(fileno(file), &sb) == 0
+                  && static_cast<size_t>(sb.st_size) == sizeof(BinaryIndexHeader) + header.entries * sizeof(Index);
+        fileSize = isValid ? sb.st_size : 0;
+        if (isValid) {
+            data = (char*) mmap(NULL, fileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno(file), 0);
+            isValid = data != MAP_FAILED;
+        }
+    }
+    if (fclose(file) != 0) {
+        Debug(Debug::ERROR) << "Cannot close file " << binaryIndexFile << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+    if (isValid == false) {
+        return false;
+    }
+
+    Index* entries = reinterpret_cast<Index*>(data + sizeof(BinaryIndexHeader));
+    if (XXH64(entries, header.entries * sizeof(Index), 0) != header.checksum) {
+        Debug(Debug::WARNING) << "Binary index " << binaryIndexFile << " is corrupt, reading the text index\n";
+        FileUtil::munmapData(data, fileSize);
+        return false;
+    }
+
+    // the entries start after the header, close unmaps the whole file
+    index = entries;
+    indexMapped = true;
+    indexMappedSize = fileSize;
+    size = header.entries;
+    dataSize = header.dataSize;
+    lastKey = header.lastKey;
+    maxSeqLen = header.maxSeqLen;
+    return true;
+}
+
+template <typename T> bool DBReader<T>::getIndexFileStamp(const char *indexFileName, uint64_t &fileSize, int64_t &mtime) {
+    struct stat sb;
+    if (::stat(indexFileName, &sb) != 0) {
+        return false;
+    }
+    fileSize = sb.st_size;
+#ifdef __APPLE__
+    mtime = static_cast<int64_t>(sb.st_mtimespec.tv_sec) * 1000000000 + sb.st_mtimespec.tv_nsec;
+#else
+    mtime = static_cast<int64_t>(sb.st_mtim.tv_sec) * 1000000000 + sb.st_mtim.tv_nsec;
+#endif
+    return true;
+}
+
 template <typename T> size_t DBReader<T>::getAminoAcidDBSize() {
     checkClosed();
     if (Parameters::isEqualDbtype(dbtype, Parameters::DBTYPE_HMM_PROFILE) || Parameters::isEqualDbtype(dbtype, Parameters::DBTYPE_PROFILE_STATE_PROFILE)) {
@@ -550,6 +740,9 @@ template <typename T> size_t DBReader<T>::getAminoAcidDBSize() {
 }
 
 template <typename T> char* DBReader<T>::getData(size_t id, int thrIdx){
+    if (prefetchCursors != NULL) {
+        prefetch(id, thrIdx);
+    }
     if(compression == COMPRESSED){
         return getDataCompressed(id, thrIdx);
     }else{
@@ -557,6 +750,56 @@ template <typename T> char* DBReader<T>::getData(size_t id, int thrIdx){
     }
 }
 
+template <typename T> void DBReader<T>::prefetch(size_t id, int thrIdx) {
+    size_t offset = index[id].offset;
+    prefetchCursors[thrIdx * PREFETCH_CURSOR_STRIDE].store(offset, std::memory_order_release);
+    // refill once the threads passed half of the requested window
+    size_t end = prefetchEnd.load(std::memory_order_acquire);
+    if (end >= totalDataSize || offset + PREFETCH_WINDOW / 2 < end) {
+        return;
+    }
+#pragma omp critical(DBReader_prefetch)
+    {
+        end = prefetchEnd.load(std::memory_order_acquire);
+        if (end < totalDataSize && offset + PREFETCH_WINDOW / 2 >= end) {
+            size_t start = std::max(end, offset);
+            end = std::min(offset + PREFETCH_WINDOW, totalDataSize);
+            prefetchEnd.store(end, std::memory_order_release);
+            // the kernel reads the range asynchronously
+            adviseDataRange(start, end, MADV_WILLNEED);
+
+            size_t consumed = SIZE_MAX;
+            for (int i = 0; i < threads; ++i) {
+                consumed = std::min(consumed, prefetchCursors[i * PREFETCH_CURSOR_STRIDE].load(std::memory_order_acquire));
+            }
+            // released pages are read again from the file if needed, this only bounds the resident memory
+            if (consumed != SIZE_MAX && consumed >= releasedEnd + PREFETCH_WINDOW) {
+                adviseDataRange(releasedEnd, consumed, MADV_DONTNEED);
+                releasedEnd = consumed;
+            }
+        }
+    }
+}
+
+template <typename T> void DBReader<T>::adviseDataRange(size_t start, size_t end, int advice) {
+    const size_t pageSize = MemoryMapped::getpagesize();
+    for (size_t fileIdx = 0; fileIdx < dataFileCnt; fileIdx++) {
+        if (end <= dataSizeOffset[fileIdx] || start >= dataSizeOffset[fileIdx + 1]) {
+            continue;
+        }
+        size_t fileStart = std::max(start, dataSizeOffset[fileIdx]) - dataSizeOffset[fileIdx];
+        size_t fileEnd = std::min(end, dataSizeOffset[fileIdx + 1]) - dataSizeOffset[fileIdx];
+        fileStart -= fileStart % pageSize;
+        // keep the page of the entry at the end of a released range
+        if (advice == MADV_DONTNEED) {
+            fileEnd -= fileEnd % pageSize;
+        }
+        if (fileEnd > fileStart) {
+            madvise(dataFiles[fileIdx] + fileStart, fileEnd - fileStart, advice);
+        }
+    }
+}
+
 template <typename T> char* DBReader<T>::getDataUncompressed(size_t id){
     checkClosed();
     if(!(dataMode & USE_DATA)) {
@@ -1064,6 +1307,12 @@ void DBReader<T>::moveDb(const std::string &srcDbName, const std::string &dstDbN
     if (FileUtil::fileExists((srcDbName + ".lookup").c_str())) {
         FileUtil::move((srcDbName + ".lookup").c_str(), (dstDbName + ".lookup").c_str());
     }
+    if (FileUtil::fileExists((srcDbName + ".dict").c_str())) {
+        FileUtil::move((srcDbName + ".dict").c_str(), (dstDbName + ".dict").c_str());
+    }
+    if (FileUtil::fileExists((srcDbName + ".index.bin").c_str())) {
+        FileUtil::move((srcDbName + ".index.bin").c_str(), (dstDbName + ".index.bin").c_str());
+    }
 }
 
 template<typename T>
@@ -1088,6 +1337,14 @@ void DBReader<T>::removeDb(const std::string &databaseName){
     if (FileUtil::fileExists(lookupFile.c_str())) {
         FileUtil::remove(lookupFile.c_str());
     }
+    std::string dictionaryFile = databaseName + ".dict";
+    if (FileUtil::fileExists(dictionaryFile.c_str())) {
+        FileUtil::remove(dictionaryFile.c_str());
+    }
+    std::string binaryIndexFile = databaseName + ".index.bin";
+    if (FileUtil::fileExists(binaryIndexFile.c_str())) {
+        FileUtil::remove(binaryIndexFile.c_str());
+    }
 }
 
 void copyLinkDb(const std::string &databaseName, const std::string &outDb, DBFiles::Files dbFilesFlags, bool link) {
@@ -1142,10 +1399,17 @@ void copyLinkDb(const std::string &databaseName, const std::string &outDb, DBFil
         { DBFiles::CA3M_SEQ_IDX,  "_sequence.ffindex" },
         { DBFiles::CA3M_HDR,      "_header.ffdata"    },
         { DBFiles::CA3M_HDR_IDX,  "_header.ffindex"   },
+        { DBFiles::DATA_DICT,     ".dict"             },
+        { DBFiles::HEADER_DICT,   "_h.dict"           },
+        { DBFiles::DATA_INDEX_BIN, ".index.bin"       },
     };
 
     for (size_t i = 0; i < ARRAY_SIZE(suffices); ++i) {
         std::string file = databaseName + suffices[i].suffix;
+        // a copied text index gets a new modification time, which invalidates a copied binary index
+        if (link == false && suffices[i].flag == DBFiles::DATA_INDEX_BIN) {
+            continue;
+        }
         if (dbFilesFlags & suffices[i].flag && FileUtil::fileExists(file.c_str())) {
             if (link) {
                 FileUtil::symlinkAbs(file, outDb + suffices[i].suffix);
@@ -7,6 +7,8 @@
 //
 #include "MemoryTracker.h"
 #include <cstddef>
+#include <cstdint>
+#include <atomic>
 #include <utility>
 #include <vector>
 #include <string>
@@ -38,19 +40,42 @@ struct DBFiles {
         CA3M_SEQ_IDX      = (1ull << 15),
         CA3M_HDR          = (1ull << 16),
         CA3M_HDR_IDX      = (1ull << 17),
+        DATA_DICT         = (1ull << 18),
+        HEADER_DICT       = (1ull << 19),
+        DATA_INDEX_BIN    = (1ull << 20),
 
 
-        GENERIC           = DATA | DATA_INDEX | DATA_DBTYPE,
-        HEADERS           = HEADER | HEADER_INDEX | HEADER_DBTYPE,
+        GENERIC           = DATA | DATA_INDEX | DATA_DBTYPE | DATA_DICT | DATA_INDEX_BIN,
+        HEADERS           = HEADER | HEADER_INDEX | HEADER_DBTYPE | HEADER_DICT,
         TAXONOMY          = TAX_MAPPING | TAX_NAMES | TAX_NODES | TAX_MERGED,
         SEQUENCE_DB       = GENERIC | HEADERS | TAXONOMY | LOOKUP | SOURCE,
         SEQUENCE_ANCILLARY= SEQUENCE_DB & (~GENERIC),
-        SEQUENCE_NO_DATA_INDEX = SEQUENCE_DB & (~DATA_INDEX),
+        SEQUENCE_NO_DATA_INDEX = SEQUENCE_DB & (~(DATA_INDEX | DATA_INDEX_BIN)),
 
         ALL               = (size_t) -1,
     };
 };
 
+// header of the binary index (<index>.bin) that DBWriter writes next to large text indices
+// it is followed by the Index entries sorted by id and is only used while the text index is unchanged
+struct BinaryIndexHeader {
+    static const uint64_t MAGIC = 0x5844494e4942534dull; // "MSBINIDX"
+    static const uint32_t VERSION = 1;
+
+    uint64_t magic;
+    uint32_t version;
+    uint32_t entrySize;
+    uint64_t entries;
+    uint64_t dataSize;
+    uint32_t lastKey;
+    uint32_t maxSeqLen;
+    // size and modification time (ns) of the text index
+    uint64_t indexFileSize;
+    int64_t indexFileMtime;
+    // XXH64 of the entries
+    uint64_t checksum;
+};
+
 template <typename T>
 class DBReader : public MemoryTracker {
 public:
@@ -261,6 +286,9 @@ public:
     static const unsigned int USE_FREAD      = 4;
     static const unsigned int USE_LOOKUP     = 8;
     static const unsigned int USE_LOOKUP_REV = 16;
+    // read ahead of and release behind the threads when the data is accessed in offset order
+    // only for readers walked by local id after opening with LINEAR_ACCCESS, not for lookups by key
+    static const unsigned int USE_PREFETCH   = 32;
 
 
     // compressed
@@ -296,6 +324,9 @@ public:
     static void softlinkDb(const std::string &databaseName, const std::string &outDb, DBFiles::Files dbFilesFlags = DBFiles::ALL);
     static void copyDb(const std::string &databaseName, const std::string &outDb, DBFiles::Files dbFilesFlags = DBFiles::ALL);
 
+    // size and modification time of a text index, a binary index is only valid for matching values
+    static bool getIndexFileStamp(const char *indexFileName, uint64_t &fileSize, int64_t &mtime);
+
     char *mmapData(FILE *file, size_t *dataSize);
 
     bool readIndex(char *data, size_t indexDataSize, Index *index, size_t & dataSize);
@@ -419,6 +450,13 @@ public:
 private:
     void checkClosed() const;
 
+    void readDictionaries(const std::string &dictionaryFile);
+
+    bool readBinaryIndex();
+
+    void prefetch(size_t id, int thrIdx);
+    void adviseDataRange(size_t start, size_t end, int advice);
+
     int threads;
 
     int dataMode;
@@ -451,6 +489,9 @@ private:
     char ** compressedBuffers;
     size_t * compressedBufferSizes;
     ZSTD_DStream ** dstream;
+    // compression dictionaries of the data file and the dictionary each dstream is currently set up with
+    std::vector<ZSTD_DDict*> ddicts;
+    unsigned int * dstreamDictIds;
 
     Index * index;
     size_t lookupSize;
@@ -464,9 +505,21 @@ private:
     int accessType;
 
     bool externalData;
+    // index is a private mapping of the binary index instead of an allocation
+    bool indexMapped;
+    size_t indexMappedSize;
 
     bool didMlock;
 
+    // USE_PREFETCH: data offset of the entry each thread is reading, one cache line per thread
+    // the cursors and prefetchEnd are read outside of the critical section that advances the window
+    std::atomic<size_t> * prefetchCursors;
+    // data up to prefetchEnd was requested, data below releasedEnd was released
+    std::atomic<size_t> prefetchEnd;
+    size_t releasedEnd;
+    static const size_t PREFETCH_WINDOW = 64 * 1024 * 1024;
+    static const size_t PREFETCH_CURSOR_STRIDE = 8;
+
     // needed to prevent the compiler from optimizing away the loop
     char magicBytes;
 
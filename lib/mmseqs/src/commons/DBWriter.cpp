@@ -1,3 +1,7 @@
+// include xxhash early to avoid incompatibilites with SIMDe
+#define XXH_INLINE_ALL
+#include "xxhash.h"
+
 #include "DBWriter.h"
 #include "DBReader.h"
 #include "Debug.h"
@@ -15,13 +19,14 @@
 #include <cstdio>
 #include <sstream>
 #include <unistd.h>
+#include <zdict.h>
 
 #ifdef OPENMP
 #include <omp.h>
 #endif
 
 DBWriter::DBWriter(const char *dataFileName_, const char *indexFileName_, unsigned int threads, size_t mode, int dbtype)
-        : threads(threads), mode(mode), dbtype(dbtype) {
+        : threads(threads), mode((mode & Parameters::WRITER_COMPRESSED_DICTIONARY_MODE) != 0 ? (mode | Parameters::WRITER_COMPRESSED_MODE) : mode), dbtype(dbtype) {
     dataFileName = strdup(dataFileName_);
     indexFileName = strdup(indexFileName_);
 
@@ -34,7 +39,9 @@ DBWriter::DBWriter(const char *dataFileName_, const char *indexFileName_, unsign
     indexFileNames = new char *[threads];
     compressedBuffers=NULL;
     compressedBufferSizes=NULL;
-    if((mode & Parameters::WRITER_COMPRESSED_MODE) != 0){
+    dictionaryState = DICTIONARY_FAILED;
+    cdict = NULL;
+    if((this->mode & Parameters::WRITER_COMPRESSED_MODE) != 0){
         compressedBuffers = new char*[threads];
         compressedBufferSizes = new size_t[threads];
         cstream = new ZSTD_CStream*[threads];
@@ -42,13 +49,16 @@ DBWriter::DBWriter(const char *dataFileName_, const char *indexFileName_, unsign
         threadBuffer = new char*[threads];
         threadBufferSize = new size_t[threads];
         threadBufferOffset = new size_t[threads];
+        threadSamples = new std::string[threads];
+        threadSampling = new bool[threads];
+        threadDictionary = new bool[threads];
     }
 
     starts = new size_t[threads];
     std::fill(starts, starts + threads, 0);
     offsets = new size_t[threads];
     std::fill(offsets, offsets + threads, 0);
-    if((mode & Parameters::WRITER_COMPRESSED_MODE) != 0 ){
+    if((this->mode & Parameters::WRITER_COMPRESSED_MODE) != 0 ){
         datafileMode = "wb+";
     } else {
         datafileMode = "wb";
@@ -92,6 +102,9 @@ DBWriter::~DBWriter() {
         delete [] compressedBufferSizes;
         delete [] cstream;
         delete [] state;
+        delete [] threadSamples;
+        delete [] threadSampling;
+        delete [] threadDictionary;
     }
 }
 
@@ -132,6 +145,22 @@ void DBWriter::open(size_t bufferSize) {
             bufferSize = 32ull * 1024 * 1024;
         }
     }
+
+    // sequence entries are copied verbatim into other files (e.g. the prefilter index), so they are never
+    // compressed with a dictionary
+    dictionaryState = DICTIONARY_FAILED;
+    if ((mode & Parameters::WRITER_COMPRESSED_DICTIONARY_MODE) != 0) {
+        const bool isSequenceDb = Parameters::isEqualDbtype(dbtype, Parameters::DBTYPE_AMINO_ACIDS)
+                                  || Parameters::isEqualDbtype(dbtype, Parameters::DBTYPE_NUCLEOTIDES)
+                                  || Parameters::isEqualDbtype(dbtype, Parameters::DBTYPE_HMM_PROFILE)
+                                  || Parameters::isEqualDbtype(dbtype, Parameters::DBTYPE_PROFILE_STATE_SEQ)
+                                  || Parameters::isEqualDbtype(dbtype, Parameters::DBTYPE_PROFILE_STATE_PROFILE)
+                                  || Parameters::isEqualDbtype(dbtype, Parameters::DBTYPE_INDEX_DB);
+        if (isSequenceDb == false) {
+            dictionaryState = DICTIONARY_SAMPLING;
+        }
+    }
+
     for (unsigned int i = 0; i < threads; i++) {
         dataFileNames[i] = makeResultFilename(dataFileName, i);
         indexFileNames[i] = makeResultFilename(indexFileName, i);
@@ -184,6 +213,8 @@ void DBWriter::open(size_t bufferSize) {
             threadBuffer[i] = (char*) malloc(threadBufferSize[i]);
             incrementMemory(threadBufferSize[i]);
             cstream[i] = ZSTD_createCStream();
+            threadSampling[i] = (dictionaryState == DICTIONARY_SAMPLING);
+            threadDictionary[i] = false;
         }
     }
 
@@ -233,14 +264,24 @@ void DBWriter::close(bool merge, bool needsSort) {
             free(threadBuffer[i]);
             decrementMemory(threadBufferSize[i]);
             ZSTD_freeCStream(cstream[i]);
+            std::string().swap(threadSamples[i]);
+        }
+        if (cdict != NULL) {
+            ZSTD_freeCDict(cdict);
+            cdict = NULL;
         }
+        std::string().swap(dictionarySamples);
+        std::vector<size_t>().swap(dictionarySampleSizes);
     }
 
     merge = getenv("MMSEQS_FORCE_MERGE") != NULL ? true : merge;
+    // flat files (no dbtype) are read without their index, their parts have to stay back to back
     mergeResults(dataFileName, indexFileName, (const char **) dataFileNames, (const char **) indexFileNames,
-                 threads, merge, ((mode & Parameters::WRITER_LEXICOGRAPHIC_MODE) != 0), needsSort);
+                 threads, merge, ((mode & Parameters::WRITER_LEXICOGRAPHIC_MODE) != 0), needsSort,
+                 dbtype != Parameters::DBTYPE_OMIT_FILE);
 
     writeDbtypeFile(dataFileName, dbtype, (mode & Parameters::WRITER_COMPRESSED_MODE) != 0);
+    writeDictionary();
 
     for (unsigned int i = 0; i < threads; i++) {
         delete [] dataFilesBuffer[i];
@@ -261,8 +302,12 @@ void DBWriter::writeStart(unsigned int thrIdx) {
     if((mode & Parameters::WRITER_COMPRESSED_MODE) != 0){
         state[thrIdx] = INIT_STATE;
         threadBufferOffset[thrIdx]=0;
-        int cLevel = 3;
-        size_t const initResult = ZSTD_initCStream(cstream[thrIdx], cLevel);
+        size_t initResult;
+        if (threadDictionary[thrIdx]) {
+            initResult = ZSTD_initCStream_usingCDict(cstream[thrIdx], cdict);
+        } else {
+            initResult = ZSTD_initCStream(cstream[thrIdx], COMPRESSION_LEVEL);
+        }
         if (ZSTD_isError(initResult)) {
             Debug(Debug::ERROR) << "ZSTD_initCStream() error in thread " << thrIdx << ". Error "
                                 << ZSTD_getErrorName(initResult) << "\n";
@@ -284,6 +329,9 @@ size_t DBWriter::writeAdd(const char* data, size_t dataSize, unsigned int thrIdx
     size_t totalWriten = 0;
     if(isCompressedDB && (state[thrIdx] == INIT_STATE || state[thrIdx] == COMPRESSED) ) {
         state[thrIdx] = COMPRESSED;
+        if (threadSampling[thrIdx] && threadSamples[thrIdx].size() < DICTIONARY_MAX_SAMPLE) {
+            threadSamples[thrIdx].append(data, std::min(dataSize, DICTIONARY_MAX_SAMPLE - threadSamples[thrIdx].size()));
+        }
         // zstd seems to have a hard time with elements < 60
         ZSTD_inBuffer input = { data, dataSize, 0 };
         while (input.pos < input.size) {
@@ -387,6 +435,79 @@ void DBWriter::writeEnd(unsigned int key, unsigned int thrIdx, bool addNullByte,
         }
         writeIndexEntry(key, starts[thrIdx], length, thrIdx);
     }
+
+    if (isCompressedDB && threadSampling[thrIdx]) {
+        addDictionarySample(thrIdx);
+    }
+}
+
+void DBWriter::addDictionarySample(unsigned int thrIdx) {
+    std::string &sample = threadSamples[thrIdx];
+    if (sample.empty()) {
+        return;
+    }
+#pragma omp critical(DBWriter_dictionary)
+    {
+        if (dictionaryState == DICTIONARY_SAMPLING) {
+            dictionarySamples.append(sample);
+            dictionarySampleSizes.emplace_back(sample.size());
+            if (dictionarySamples.size() >= DICTIONARY_SAMPLE_SIZE) {
+                trainDictionary();
+            }
+        }
+        // entries written before the dictionary was trained stay plain zstd frames
+        if (dictionaryState != DICTIONARY_SAMPLING) {
+            threadSampling[thrIdx] = false;
+            threadDictionary[thrIdx] = (dictionaryState == DICTIONARY_TRAINED);
+        }
+    }
+    sample.clear();
+}
+
+void DBWriter::trainDictionary() {
+    dictionary.resize(DICTIONARY_CAPACITY);
+    size_t dictionarySize = ZDICT_trainFromBuffer(&dictionary[0], dictionary.size(),
+                                                  dictionarySamples.data(), dictionarySampleSizes.data(),
+                                                  static_cast<unsigned int>(dictionarySampleSizes.size()));
+    if (ZDICT_isError(dictionarySize)) {
+        Debug(Debug::WARNING) << "Cannot train compression dictionary for " << dataFileName << ". Error "
+                              << ZDICT_getErrorName(dictionarySize) << "\n";
+        dictionary.clear();
+        dictionaryState = DICTIONARY_FAILED;
+    } else {
+        dictionary.resize(dictionarySize);
+        cdict = ZSTD_createCDict(dictionary.data(), dictionary.size(), COMPRESSION_LEVEL);
+        if (cdict == NULL) {
+            Debug(Debug::ERROR) << "ZSTD_createCDict() error for " << dataFileName << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+        dictionaryState = DICTIONARY_TRAINED;
+    }
+    std::string().swap(dictionarySamples);
+    std::vector<size_t>().swap(dictionarySampleSizes);
+}
+
+void DBWriter::writeDictionary() {
+    std::string dictionaryFile = std::string(dataFileName) + ".dict";
+    if (dictionaryState != DICTIONARY_TRAINED) {
+        // do not leave the dictionary of an earlier run behind
+        if (FileUtil::fileExists(dictionaryFile.c_str())) {
+            FileUtil::remove(dictionaryFile.c_str());
+        }
+        return;
+    }
+
+    FILE* file = FileUtil::openAndDelete(dictionaryFile.c_str(), "wb");
+    unsigned int dictionarySize = static_cast<unsigned int>(dictionary.size());
+    if (fwrite(&dictionarySize, sizeof(unsigned int), 1, file) != 1
+        || fwrite(dictionary.data(), sizeof(char), dictionary.size(), file) != dictionary.size()) {
+        Debug(Debug::ERROR) << "Cannot write to dictionary file " << dictionaryFile << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+    if (fclose(file) != 0) {
+        Debug(Debug::ERROR) << "Cannot close file " << dictionaryFile << "\n";
+        EXIT(EXIT_FAILURE);
+    }
 }
 
 void DBWriter::writeIndexEntry(unsigned int key, size_t offset, size_t length, unsigned int thrIdx){
@@ -468,6 +589,37 @@ void DBWriter::mergeResults(const std::string &outFileName, const std::string &o
             }
         }
     }
+
+    // each part may carry its own compression dictionary, entries find theirs by the dictionary id
+    std::vector<FILE*> dictionaryFiles;
+    for (size_t i = 0; i < files.size(); i++) {
+        std::string dictionaryFile = files[i].first + ".dict";
+        if (FileUtil::fileExists(dictionaryFile.c_str())) {
+            dictionaryFiles.emplace_back(FileUtil::openFileOrDie(dictionaryFile.c_str(), "r", true));
+        }
+    }
+    std::string dictionaryDest = outFileName + ".dict";
+    if (dictionaryFiles.empty()) {
+        if (FileUtil::fileExists(dictionaryDest.c_str())) {
+            FileUtil::remove(dictionaryDest.c_str());
+        }
+    } else {
+        FILE *outFh = FileUtil::openAndDelete(dictionaryDest.c_str(), "w");
+        Concat::concatFiles(dictionaryFiles, outFh);
+        if (fclose(outFh) != 0) {
+            Debug(Debug::ERROR) << "Cannot close file " << dictionaryDest << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+        for (size_t i = 0; i < dictionaryFiles.size(); i++) {
+            fclose(dictionaryFiles[i]);
+        }
+        for (size_t i = 0; i < files.size(); i++) {
+            std::string dictionaryFile = files[i].first + ".dict";
+            if (FileUtil::fileExists(dictionaryFile.c_str())) {
+                FileUtil::remove(dictionaryFile.c_str());
+            }
+        }
+    }
 }
 
 template <>
@@ -522,8 +674,13 @@ void DBWriter::writeIndex(FILE *outFile, size_t indexSize, DBReader<std::string>
 void DBWriter::mergeResults(const char *outFileName, const char *outFileNameIndex,
                             const char **dataFileNames, const char **indexFileNames,
                             unsigned long fileCount, bool mergeDatafiles,
-                            bool lexicographicOrder, bool indexNeedsToBeSorted) {
+                            bool lexicographicOrder, bool indexNeedsToBeSorted, bool alignParts) {
     Timer timer;
+    // a binary index of a previous run would be stale, sortIndex writes a new one if needed
+    std::string binaryIndexFile = std::string(outFileNameIndex) + ".bin";
+    if (FileUtil::fileExists(binaryIndexFile.c_str())) {
+        FileUtil::remove(binaryIndexFile.c_str());
+    }
     std::vector<std::vector<std::string>> dataFilenames;
     for (unsigned int i = 0; i < fileCount; ++i) {
         dataFilenames.emplace_back(FileUtil::findDatafiles(dataFileNames[i]));
@@ -532,10 +689,16 @@ void DBWriter::mergeResults(const char *outFileName, const char *outFileNameInde
     // merge results into one result file
     if (dataFilenames.size() > 1) {
         std::vector<FILE*> datafiles;
-        std::vector<size_t> mergedSizes;
+        std::vector<size_t> datafileSizes;
+        // offset of the data of each index in the merged data
+        std::vector<size_t> mergedOffsets;
+        size_t totalSize = 0;
+        // parts may only be moved apart if they have their own index and the data is only read through the index
+        bool alignFiles = alignParts;
         for (unsigned int i = 0; i < dataFilenames.size(); i++) {
             std::vector<std::string>& filenames = dataFilenames[i];
-            size_t cumulativeSize = 0;
+            mergedOffsets.push_back(totalSize);
+            alignFiles = alignFiles && (filenames.size() == 1);
             for (size_t j = 0; j < filenames.size(); ++j) {
                 FILE* fh = fopen(filenames[j].c_str(), "r");
                 if (fh == NULL) {
@@ -549,18 +712,25 @@ void DBWriter::mergeResults(const char *outFileName, const char *outFileNameInde
                     EXIT(EXIT_FAILURE);
                 }
                 datafiles.emplace_back(fh);
-                cumulativeSize += sb.st_size;
+                datafileSizes.emplace_back(sb.st_size);
+                totalSize += sb.st_size;
             }
-            mergedSizes.push_back(cumulativeSize);
         }
 
         if (mergeDatafiles) {
             FILE *outFh = FileUtil::openAndDelete(outFileName, "w");
-            Concat::concatFiles(datafiles, outFh);
+            // without reflinks or copy_file_range, parts that are only read through the index stay a multi-file database
+            std::vector<size_t> fileOffsets = Concat::concatFilesAt(datafiles, datafileSizes, outFh, alignFiles, alignFiles);
             if (fclose(outFh) != 0) {
                 Debug(Debug::ERROR) << "Cannot close data file " << outFileName << "\n";
                 EXIT(EXIT_FAILURE);
             }
+            if (fileOffsets.empty()) {
+                FileUtil::remove(outFileName);
+                mergeDatafiles = false;
+            } else if (alignFiles) {
+                mergedOffsets = fileOffsets;
+            }
         }
 
         for (unsigned int i = 0; i < datafiles.size(); ++i) {
@@ -580,7 +750,7 @@ void DBWriter::mergeResults(const char *outFileName, const char *outFileNameInde
         }
 
         // merge index
-        mergeIndex(indexFileNames, dataFilenames.size(), mergedSizes);
+        mergeIndex(indexFileNames, dataFilenames.size(), mergedOffsets);
     } else if (dataFilenames.size() == 1) {
         std::vector<std::string>& filenames = dataFilenames[0];
         if (filenames.size() == 1) {
@@ -613,14 +783,14 @@ void DBWriter::mergeResults(const char *outFileName, const char *outFileNameInde
     Debug(Debug::INFO) << "Time for merging to " << FileUtil::baseName(outFileName) << ": " << timer.lap() << "\n";
 }
 
-void DBWriter::mergeIndex(const char** indexFilenames, unsigned int fileCount, const std::vector<size_t> &dataSizes) {
+void DBWriter::mergeIndex(const char** indexFilenames, unsigned int fileCount, const std::vector<size_t> &dataOffsets) {
     FILE *index_file = fopen(indexFilenames[0], "a");
     if (index_file == NULL) {
         perror(indexFilenames[0]);
         EXIT(EXIT_FAILURE);
     }
-    size_t globalOffset = dataSizes[0];
     for (unsigned int fileIdx = 1; fileIdx < fileCount; fileIdx++) {
+        const size_t globalOffset = dataOffsets[fileIdx];
         DBReader<unsigned int> reader(indexFilenames[fileIdx], indexFilenames[fileIdx], 1, DBReader<unsigned int>::USE_INDEX);
         reader.open(DBReader<unsigned int>::HARDNOSORT);
         if (reader.getSize() > 0) {
@@ -633,8 +803,6 @@ void DBWriter::mergeIndex(const char** indexFilenames, unsigned int fileCount, c
         }
         reader.close();
         FileUtil::remove(indexFilenames[fileIdx]);
-
-        globalOffset += dataSizes[fileIdx];
     }
     if (fclose(index_file) != 0) {
         Debug(Debug::ERROR) << "Cannot close index file " << indexFilenames[0] << "\n";
@@ -654,6 +822,9 @@ void DBWriter::sortIndex(const char *inFileNameIndex, const char *outFileNameInd
             Debug(Debug::ERROR) << "Cannot close index file " << outFileNameIndex << "\n";
             EXIT(EXIT_FAILURE);
         }
+        if (indexReader.getSize() >= BINARY_INDEX_MIN_ENTRIES) {
+            writeBinaryIndex(outFileNameIndex, indexReader);
+        }
         indexReader.close();
 
     } else {
@@ -670,6 +841,60 @@ void DBWriter::sortIndex(const char *inFileNameIndex, const char *outFileNameInd
     }
 }
 
+void DBWriter::writeBinaryIndex(const char *outFileNameIndex, DBReader<unsigned int> &indexReader) {
+    BinaryIndexHeader header;
+    memset(&header, 0, sizeof(BinaryIndexHeader));
+    header.magic = BinaryIndexHeader::MAGIC;
+    header.version = BinaryIndexHeader::VERSION;
+    header.entrySize = sizeof(DBReader<unsigned int>::Index);
+    header.entries = indexReader.getSize();
+    header.dataSize = indexReader.getDataSize();
+    header.lastKey = indexReader.getLastKey();
+    header.maxSeqLen = indexReader.getMaxSeqLen();
+    if (DBReader<unsigned int>::getIndexFileStamp(outFileNameIndex, header.indexFileSize, header.indexFileMtime) == false) {
+        Debug(Debug::ERROR) << "Cannot stat index file " << outFileNameIndex << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+
+    std::string binaryIndexFile = std::string(outFileNameIndex) + ".bin";
+    FILE *file = FileUtil::openAndDelete(binaryIndexFile.c_str(), "w");
+    // header is rewritten with the checksum once all entries are written
+    if (fwrite(&header, sizeof(BinaryIndexHeader), 1, file) != 1) {
+        Debug(Debug::ERROR) << "Cannot write binary index file " << binaryIndexFile << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+
+    // copy in batches with zeroed padding so that the checksum does not depend on uninitialized bytes
+    const size_t BATCH_SIZE = 65536;
+    std::vector<DBReader<unsigned int>::Index> batch(BATCH_SIZE);
+    XXH64_state_t checksumState;
+    XXH64_reset(&checksumState, 0);
+    DBReader<unsigned int>::Index *index = indexReader.getIndex();
+    for (size_t start = 0; start < header.entries; start += BATCH_SIZE) {
+        size_t count = std::min(BATCH_SIZE, static_cast<size_t>(header.entries) - start);
+        memset(batch.data(), 0, count * sizeof(DBReader<unsigned int>::Index));
+        for (size_t i = 0; i < count; ++i) {
+            batch[i].id = index[start + i].id;
+            batch[i].offset = index[start + i].offset;
+            batch[i].length = index[start + i].length;
+        }
+        XXH64_update(&checksumState, batch.data(), count * sizeof(DBReader<unsigned int>::Index));
+        if (fwrite(batch.data(), sizeof(DBReader<unsigned int>::Index), count, file) != count) {
+            Debug(Debug::ERROR) << "Cannot write binary index file " << binaryIndexFile << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+    }
+    header.checksum = XXH64_digest(&checksumState);
+    if (fseek(file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(BinaryIndexHeader), 1, file) != 1) {
+        Debug(Debug::ERROR) << "Cannot write binary index file " << binaryIndexFile << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+    if (fclose(file) != 0) {
+        Debug(Debug::ERROR) << "Cannot close binary index file " << binaryIndexFile << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+}
+
 void DBWriter::writeThreadBuffer(unsigned int idx, size_t dataSize) {
     size_t written = fwrite(threadBuffer[idx], 1, dataSize, dataFiles[idx]);
     if (written != dataSize) {
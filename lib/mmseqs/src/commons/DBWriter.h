@@ -64,6 +64,7 @@ public:
     bool isClosed(){
         return closed;
     }
+
 private:
     size_t addToThreadBuffer(const void *data, size_t itmesize, size_t nitems, int threadIdx);
     void writeThreadBuffer(unsigned int idx, size_t dataSize);
@@ -73,12 +74,21 @@ private:
     static void mergeResults(const char *outFileName, const char *outFileNameIndex,
                              const char **dataFileNames, const char **indexFileNames,
                              unsigned long fileCount, bool mergeDatafiles,
-                             bool lexicographicOrder = false, bool indexNeedsToBeSorted = true);
+                             bool lexicographicOrder = false, bool indexNeedsToBeSorted = true,
+                             bool alignParts = false);
 
-    static void mergeIndex(const char** indexFilenames, unsigned int fileCount, const std::vector<size_t> &dataSizes);
+    static void mergeIndex(const char** indexFilenames, unsigned int fileCount, const std::vector<size_t> &dataOffsets);
 
     static void sortIndex(const char *inFileNameIndex, const char *outFileNameIndex, const bool lexicographicOrder);
 
+    // sorted numeric indices with at least BINARY_INDEX_MIN_ENTRIES entries are also written as <index>.bin
+    static void writeBinaryIndex(const char *outFileNameIndex, DBReader<unsigned int> &indexReader);
+    static const size_t BINARY_INDEX_MIN_ENTRIES = 1024 * 1024;
+
+    void addDictionarySample(unsigned int thrIdx);
+    void trainDictionary();
+    void writeDictionary();
+
     char* dataFileName;
     char* indexFileName;
 
@@ -103,6 +113,24 @@ private:
     static const int COMPRESSED=2;
     ZSTD_CStream** cstream;
 
+    static const int COMPRESSION_LEVEL = 3;
+    static const size_t DICTIONARY_CAPACITY = 32 * 1024;
+    static const size_t DICTIONARY_SAMPLE_SIZE = 256 * 1024;
+    static const size_t DICTIONARY_MAX_SAMPLE = 64 * 1024;
+    static const int DICTIONARY_SAMPLING = 0;
+    static const int DICTIONARY_TRAINED = 1;
+    static const int DICTIONARY_FAILED = 2;
+    int dictionaryState;
+    // raw entries of all threads, the dictionary is trained once DICTIONARY_SAMPLE_SIZE bytes are collected
+    std::string dictionarySamples;
+    std::vector<size_t> dictionarySampleSizes;
+    std::string dictionary;
+    ZSTD_CDict* cdict;
+    // raw data of the entry that is currently written by each thread
+    std::string* threadSamples;
+    bool* threadSampling;
+    bool* threadDictionary;
+
     const unsigned int threads;
     const size_t mode;
     int dbtype;
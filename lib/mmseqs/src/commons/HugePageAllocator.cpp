@@ -0,0 +1,139 @@
+#include "HugePageAllocator.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+#define HAVE_HUGE_PAGES 1
+#endif
+
+static size_t roundUpToHugePage(size_t size) {
+    return (size + HugePageAllocator::HUGE_PAGE_SIZE - 1) & ~(HugePageAllocator::HUGE_PAGE_SIZE - 1);
+}
+
+int HugePageAllocator::getMode() {
+#ifdef HAVE_HUGE_PAGES
+    // read once, so that deallocate always takes the path of the matching allocate
+    static const int mode = []() {
+        const char *env = getenv("MMSEQS_HUGE_PAGES");
+        if (env == NULL) {
+            return static_cast<int>(MODE_TRANSPARENT);
+        }
+        int value = atoi(env);
+        return (value < MODE_OFF || value > MODE_RESERVED) ? static_cast<int>(MODE_TRANSPARENT) : value;
+    }();
+    return mode;
+#else
+    return MODE_OFF;
+#endif
+}
+
+void *HugePageAllocator::allocate(size_t size) {
+    if (useMapping(size) == false) {
+        return calloc(size, 1);
+    }
+#ifdef HAVE_HUGE_PAGES
+    const size_t mappedSize = roundUpToHugePage(size);
+#ifdef MAP_HUGETLB
+    if (getMode() == MODE_RESERVED) {
+        void *ptr = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (ptr != MAP_FAILED) {
+            return ptr;
+        }
+    }
+#endif
+    // over-allocate by one huge page to place the array at a huge page boundary
+    char *mapping = static_cast<char *>(mmap(NULL, mappedSize + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (mapping == MAP_FAILED) {
+        return NULL;
+    }
+    char *aligned = reinterpret_cast<char *>(roundUpToHugePage(reinterpret_cast<uintptr_t>(mapping)));
+    const size_t head = aligned - mapping;
+    if (head > 0) {
+        munmap(mapping, head);
+    }
+    const size_t tail = HUGE_PAGE_SIZE - head;
+    if (tail > 0) {
+        munmap(aligned + mappedSize, tail);
+    }
+    madvise(aligned, mappedSize, MADV_HUGEPAGE);
+    return aligned;
+#else
+    return NULL;
+#endif
+}
+
+void HugePageAllocator::deallocate(void *ptr, size_t size) {
+    if (ptr == NULL) {
+        return;
+    }
+    if (useMapping(size) == false) {
+        free(ptr);
+        return;
+    }
+#ifdef HAVE_HUGE_PAGES
+    munmap(ptr, roundUpToHugePage(size));
+#endif
+}
+
+void *HugePageAllocator::reallocate(void *ptr, size_t oldSize, size_t newSize) {
+    if (ptr == NULL) {
+        return allocate(newSize);
+    }
+    if (useMapping(oldSize) == false && useMapping(newSize) == false) {
+        char *newPtr = static_cast<char *>(realloc(ptr, newSize));
+        if (newPtr != NULL && newSize > oldSize) {
+            memset(newPtr + oldSize, 0, newSize - oldSize);
+        }
+        return newPtr;
+    }
+#ifdef HAVE_HUGE_PAGES
+    if (useMapping(oldSize) && useMapping(newSize)) {
+        const size_t oldMappedSize = roundUpToHugePage(oldSize);
+        const size_t newMappedSize = roundUpToHugePage(newSize);
+        // resizing in place keeps the huge page alignment, a moved mapping could lose it, so growth that does not fit
+        // in place is copied to a newly aligned mapping below
+        if (oldMappedSize == newMappedSize
+            || mremap(ptr, oldMappedSize, newMappedSize, 0) != MAP_FAILED) {
+            if (newSize > oldSize) {
+                // pages added by the remap are zero, the end of the last old page might hold data of a larger size
+                memset(static_cast<char *>(ptr) + oldSize, 0, std::min(newSize, oldMappedSize) - oldSize);
+                if (newMappedSize > oldMappedSize) {
+                    madvise(ptr, newMappedSize, MADV_HUGEPAGE);
+                }
+            }
+            return ptr;
+        }
+    }
+#endif
+    void *newPtr = allocate(newSize);
+    if (newPtr == NULL) {
+        return NULL;
+    }
+    memcpy(newPtr, ptr, std::min(oldSize, newSize));
+    deallocate(ptr, oldSize);
+    return newPtr;
+}
+
+void HugePageAllocator::advise(void *ptr, size_t size) {
+#ifdef HAVE_HUGE_PAGES
+    if (getMode() == MODE_OFF) {
+        return;
+    }
+    const uintptr_t begin = roundUpToHugePage(reinterpret_cast<uintptr_t>(ptr));
+    const uintptr_t end = (reinterpret_cast<uintptr_t>(ptr) + size) & ~(HUGE_PAGE_SIZE - 1);
+    if (end > begin) {
+        // failures only mean that the mapping stays on base pages
+        madvise(reinterpret_cast<void *>(begin), end - begin, MADV_HUGEPAGE);
+    }
+#else
+    (void) ptr;
+    (void) size;
+#endif
+}
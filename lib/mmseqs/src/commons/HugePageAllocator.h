@@ -0,0 +1,55 @@
+#ifndef MMSEQS_HUGEPAGEALLOCATOR_H
+#define MMSEQS_HUGEPAGEALLOCATOR_H
+
+#include <cstddef>
+
+// allocator for large arrays with random access patterns (k-mer index, diagonal counters)
+// large allocations are mapped at huge page boundaries and backed by huge pages where the system allows,
+// which saves most of the TLB misses of their random accesses
+// the backing is chosen with the environment variable MMSEQS_HUGE_PAGES:
+//   0: plain heap memory
+//   1: transparent huge pages requested with madvise (default)
+//   2: reserved huge pages (MAP_HUGETLB), transparent huge pages if none are free
+class HugePageAllocator {
+public:
+    static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    // returns zero-initialized memory or NULL if the allocation fails
+    static void *allocate(size_t size);
+
+    // size has to be the size passed to allocate
+    static void deallocate(void *ptr, size_t size);
+
+    // grows or shrinks an allocation, memory beyond oldSize is zero-initialized
+    // returns NULL and keeps the old allocation if it fails
+    static void *reallocate(void *ptr, size_t oldSize, size_t newSize);
+
+    template<typename T>
+    static T *allocateArray(size_t count) {
+        return static_cast<T *>(allocate(count * sizeof(T)));
+    }
+
+    template<typename T>
+    static void deallocateArray(T *ptr, size_t count) {
+        deallocate(ptr, count * sizeof(T));
+    }
+
+    // asks the kernel to back the huge pages fully contained in an existing mapping (e.g. a mmapped index) with huge pages
+    // file-backed mappings only get huge pages if the kernel and file system support it
+    static void advise(void *ptr, size_t size);
+
+private:
+    enum {
+        MODE_OFF = 0,
+        MODE_TRANSPARENT = 1,
+        MODE_RESERVED = 2
+    };
+
+    static int getMode();
+
+    static bool useMapping(size_t size) {
+        return size >= HUGE_PAGE_SIZE && getMode() != MODE_OFF;
+    }
+};
+
+#endif //MMSEQS_HUGEPAGEALLOCATOR_H
@@ -0,0 +1,88 @@
+#include "NumaTopology.h"
+#include "Util.h"
+
+#include <fstream>
+#include <cstdlib>
+
+NumaTopology::NumaTopology() {
+#ifdef __linux__
+    CPU_ZERO(&processCpus);
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &processCpus) != 0) {
+        return;
+    }
+    std::ifstream onlineFile("/sys/devices/system/node/online");
+    std::string online;
+    if (!std::getline(onlineFile, online)) {
+        return;
+    }
+    std::vector<int> nodes = parseCpuList(online);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        std::ifstream cpuListFile("/sys/devices/system/node/node" + SSTR(nodes[i]) + "/cpulist");
+        std::string cpuList;
+        if (!std::getline(cpuListFile, cpuList)) {
+            continue;
+        }
+        std::vector<int> cpus = parseCpuList(cpuList);
+        std::vector<int> allowedCpus;
+        for (size_t j = 0; j < cpus.size(); ++j) {
+            if (cpus[j] < CPU_SETSIZE && CPU_ISSET(cpus[j], &processCpus)) {
+                allowedCpus.push_back(cpus[j]);
+            }
+        }
+        // memory-only nodes and nodes outside the affinity mask do not get threads
+        if (allowedCpus.empty() == false) {
+            nodeCpus.push_back(allowedCpus);
+        }
+    }
+#endif
+}
+
+bool NumaTopology::bindThreadToNode(size_t node) const {
+#ifdef __linux__
+    if (node >= nodeCpus.size()) {
+        return false;
+    }
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (size_t i = 0; i < nodeCpus[node].size(); ++i) {
+        CPU_SET(nodeCpus[node][i], &cpus);
+    }
+    return sched_setaffinity(0, sizeof(cpu_set_t), &cpus) == 0;
+#else
+    return false;
+#endif
+}
+
+void NumaTopology::unbindThread() const {
+#ifdef __linux__
+    if (nodeCpus.empty() == false) {
+        sched_setaffinity(0, sizeof(cpu_set_t), &processCpus);
+    }
+#endif
+}
+
+// parses lists like "0-3,8,10-11"
+std::vector<int> NumaTopology::parseCpuList(const std::string &list) {
+    std::vector<int> cpus;
+    const char *pos = list.c_str();
+    while (*pos != '\0' && *pos != '\n') {
+        char *end;
+        long first = strtol(pos, &end, 10);
+        if (end == pos) {
+            break;
+        }
+        long last = first;
+        if (*end == '-') {
+            pos = end + 1;
+            last = strtol(pos, &end, 10);
+            if (end == pos) {
+                break;
+            }
+        }
+        for (long cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+        pos = (*end == ',') ? end + 1 : end;
+    }
+    return cpus;
+}
@@ -0,0 +1,45 @@
+#ifndef MMSEQS_NUMATOPOLOGY_H
+#define MMSEQS_NUMATOPOLOGY_H
+
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+// NUMA nodes of the CPUs the process may run on, read from sysfs
+// the nodes are empty on systems without NUMA information
+class NumaTopology {
+public:
+    NumaTopology();
+
+    size_t getNodeCount() const {
+        return nodeCpus.size();
+    }
+
+    const std::vector<int> &getCpus(size_t node) const {
+        return nodeCpus[node];
+    }
+
+    // node of a thread if the threads are spread over the nodes in contiguous blocks
+    size_t getNodeOfThread(unsigned int thread, unsigned int threads) const {
+        return nodeCpus.empty() ? 0 : (static_cast<size_t>(thread) * nodeCpus.size()) / threads;
+    }
+
+    // restricts the calling thread to the CPUs of the node, so that the memory it touches first is allocated there
+    bool bindThreadToNode(size_t node) const;
+
+    // restores the CPUs of the process for the calling thread
+    void unbindThread() const;
+
+    static std::vector<int> parseCpuList(const std::string &list);
+
+private:
+    std::vector<std::vector<int> > nodeCpus;
+#ifdef __linux__
+    cpu_set_t processCpus;
+#endif
+};
+
+#endif //MMSEQS_NUMATOPOLOGY_H
@@ -113,9 +113,17 @@ public:
     static const unsigned int EXPAND_TRANSFER_EVALUE = 0;
     static const unsigned int EXPAND_RESCORE_BACKTRACE = 1;
 
+    // the compression modes match the values of --compressed, so par.compressed can be passed as writer mode
     static const unsigned int WRITER_ASCII_MODE = 0;
     static const unsigned int WRITER_COMPRESSED_MODE = 1;
-    static const unsigned int WRITER_LEXICOGRAPHIC_MODE = 2;
+    // zstd with a dictionary trained on the first entries, ignored for sequence databases
+    static const unsigned int WRITER_COMPRESSED_DICTIONARY_MODE = 2;
+    static const unsigned int WRITER_LEXICOGRAPHIC_MODE = 4;
+
+    // header entries are copied verbatim into other files (e.g. the prefilter index), so their writers never use a dictionary
+    static unsigned int withoutDictionary(size_t writerMode) {
+        return (writerMode & WRITER_COMPRESSED_DICTIONARY_MODE) != 0 ? ((writerMode & ~WRITER_COMPRESSED_DICTIONARY_MODE) | WRITER_COMPRESSED_MODE) : writerMode;
+    }
 
     // convertalis alignment
     static const int FORMAT_ALIGNMENT_BLAST_TAB = 0;
@@ -191,6 +199,7 @@ public:
     static const int TARGET_DB_SPLIT = 0;
     static const int QUERY_DB_SPLIT = 1;
     static const int DETECT_BEST_DB_SPLIT = 2;
+    static const int THROUGHPUT_DB_SPLIT = 3;
 
     // taxonomy output
     static const int TAXONOMY_OUTPUT_LCA = 0;
@@ -223,6 +232,7 @@ public:
             case 0: return "Target";
             case 1: return "Query";
             case 2: return "Auto";
+            case 3: return "Throughput";
             default: return "Error";
         }
     };
@@ -377,6 +387,9 @@ public:
     int    split;                        // Split database in n equal chunks
     int    splitMode;                    // Split by query or target DB
     size_t splitMemoryLimit;             // Maximum memory in bytes a split can use
+    int    numaReplicate;                // Copy the prefilter index to each NUMA node
+    int    batchShortQueries;            // Match short queries in batches
+    int    compressKmerIndex;            // Store the k-mer lists of the index table compressed
     size_t diskSpaceLimit;               // Maximum disk space in bytes for sliced reverse profile search
     bool   splitAA;                      // Split database by amino acid count instead
     int    preloadMode;                  // Preload mode of database
@@ -693,6 +706,9 @@ public:
     PARAMETER(PARAM_SPLIT)
     PARAMETER(PARAM_SPLIT_MODE)
     PARAMETER(PARAM_SPLIT_MEMORY_LIMIT)
+    PARAMETER(PARAM_NUMA_REPLICATE)
+    PARAMETER(PARAM_BATCH_SHORT_QUERIES)
+    PARAMETER(PARAM_COMPRESS_KMER_INDEX)
     PARAMETER(PARAM_DISK_SPACE_LIMIT)
     PARAMETER(PARAM_SPLIT_AMINOACID)
     PARAMETER(PARAM_SUB_MAT)
@@ -1,6 +1,7 @@
 // Copyright 2010 Martin C. Frith
 
 #include "tantan.h"
+#include "simd.h"
 
 #include <algorithm>  // fill, max
 #include <cassert>
@@ -26,6 +27,12 @@ namespace tantan {
         return 1.0 / maxRepeatOffset;
     }
 
+    double sumLanes(simd_double v) {
+        double lanes[VECSIZE_DOUBLE];
+        simdf64_storeu(lanes, v);
+        return std::accumulate(lanes, lanes + VECSIZE_DOUBLE, 0.0);
+    }
+
     void checkForwardAndBackwardTotals(double fTot, double bTot) {
         double x = std::abs(fTot);
         double y = std::abs(bTot);
@@ -38,7 +45,7 @@ namespace tantan {
     }
 
     struct Tantan {
-        enum { scaleStepSize = 16 };
+        enum { scaleStepSize = 16, emissionBlockSize = 1024 };
 
         const char *seqBeg;  // start of the sequence
         const char *seqEnd;  // end of the sequence
@@ -67,6 +74,15 @@ namespace tantan {
         std::vector<double> b2fProbs;  // background state to each foreground state
         std::vector<double> foregroundProbs;
         std::vector<double> insertionProbs;
+        // likelihood ratios of each letter of the sequence against a block of the reversed sequence,
+        // so the emission probabilities of all offsets of a position are a contiguous slice of a row
+        std::vector<double> emissionProbs;
+        std::vector<int> emissionRowOf;  // row of each letter, -1 if it does not occur in the sequence
+        size_t emissionRowSize;
+        const char *emissionBlockBeg;  // positions whose emission probabilities are in the rows
+        const char *emissionBlockEnd;
+        // without indels, run the offsets in SIMD lanes instead of one at a time in the original summation order
+        bool isVectorized;
 
         std::vector<double> scaleFactors;
 
@@ -78,7 +94,8 @@ namespace tantan {
                double repeatEndProb,
                double repeatOffsetProbDecay,
                double firstGapProb,
-               double otherGapProb) {
+               double otherGapProb,
+               bool isVectorized) {
             assert(maxRepeatOffset > 0);
             assert(repeatProb >= 0 && repeatProb < 1);
             // (if repeatProb==1, then any sequence is impossible)
@@ -93,6 +110,7 @@ namespace tantan {
             this->seqPtr = seqBeg;
             this->maxRepeatOffset = maxRepeatOffset;
             this->likelihoodRatioMatrix = likelihoodRatioMatrix;
+            this->isVectorized = isVectorized;
 
             b2b = 1 - repeatProb;
             f2b = repeatEndProb;
@@ -114,6 +132,9 @@ namespace tantan {
             b2fProbs.resize(maxRepeatOffset);
             foregroundProbs.resize(maxRepeatOffset);
             insertionProbs.resize(maxRepeatOffset - 1);
+            if (isVectorized) {
+                initializeEmissionProbs();
+            }
 
             double p = b2fFirst;
             for (int i = 0; i < maxRepeatOffset; ++i) {
@@ -300,13 +321,91 @@ namespace tantan {
             }
         }
 
+        void initializeEmissionProbs() {
+            int maxLetter = 0;
+            for (const char *s = seqBeg; s < seqEnd; ++s) {
+                maxLetter = std::max(maxLetter, (int)*s);
+            }
+            emissionRowOf.assign(maxLetter + 1, -1);
+            int rows = 0;
+            for (const char *s = seqBeg; s < seqEnd; ++s) {
+                if (emissionRowOf[(int)*s] == -1) {
+                    emissionRowOf[(int)*s] = rows++;
+                }
+            }
+            size_t seqLen = seqEnd - seqBeg;
+            emissionRowSize = std::min(seqLen, (size_t)(emissionBlockSize + maxRepeatOffset));
+            emissionProbs.resize(rows * emissionRowSize);
+            emissionBlockBeg = seqBeg;
+            emissionBlockEnd = seqBeg;
+        }
+
+        void fillEmissionBlock() {
+            emissionBlockBeg = seqPtr - (seqPtr - seqBeg) % emissionBlockSize;
+            emissionBlockEnd = seqEnd - emissionBlockBeg < emissionBlockSize ? seqEnd : emissionBlockBeg + emissionBlockSize;
+            const char *windowBeg = emissionBlockBeg - seqBeg < maxRepeatOffset ? seqBeg : emissionBlockBeg - maxRepeatOffset;
+            size_t windowLen = emissionBlockEnd - windowBeg;
+            for (size_t letter = 0; letter < emissionRowOf.size(); ++letter) {
+                if (emissionRowOf[letter] == -1) {
+                    continue;
+                }
+                const double *lrRow = likelihoodRatioMatrix[letter];
+                double *row = BEG(emissionProbs) + emissionRowOf[letter] * emissionRowSize;
+                for (size_t k = 0; k < windowLen; ++k) {
+                    row[k] = lrRow[(int)emissionBlockEnd[-1 - (long)k]];
+                }
+            }
+        }
+
+        // emission probabilities of the current letter at offsets 1, 2, ...
+        const double *currentEmissionProbs() {
+            if (seqPtr < emissionBlockBeg || seqPtr >= emissionBlockEnd) {
+                fillEmissionBlock();
+            }
+            return BEG(emissionProbs) + emissionRowOf[(int)*seqPtr] * emissionRowSize + (emissionBlockEnd - seqPtr);
+        }
+
         void calcForwardTransitionAndEmissionProbs() {
             if (endGapProb > 0) {
                 calcForwardTransitionProbsWithGaps();
                 calcEmissionProbs();
                 return;
             }
+            if (isVectorized == false) {
+                calcForwardTransitionAndEmissionProbsScalar();
+                return;
+            }
+
+            double b = backgroundProb;
+            double *foregroundBeg = BEG(foregroundProbs);
+            const double *b2fBeg = BEG(b2fProbs);
+            int maxOffset = maxOffsetInTheSequence();
+            const double *emissionBeg = currentEmissionProbs();
+
+            // the offsets are independent of each other, only the sum over them is carried in the lanes
+            // summing lane by lane changes the order of the additions, so the sums agree with the scalar ones within rounding
+            simd_double bVec = simdf64_set(b);
+            simd_double f2f0Vec = simdf64_set(f2f0);
+            simd_double fromForegroundVec = simdf64_setzero(0);
+            int i = 0;
+            for (; i + VECSIZE_DOUBLE <= maxOffset; i += VECSIZE_DOUBLE) {
+                simd_double f = simdf64_loadu(foregroundBeg + i);
+                fromForegroundVec = simdf64_add(fromForegroundVec, f);
+                simd_double fromBackground = simdf64_mul(bVec, simdf64_loadu(b2fBeg + i));
+                simd_double next = simdf64_add(fromBackground, simdf64_mul(f, f2f0Vec));
+                simdf64_storeu(foregroundBeg + i, simdf64_mul(next, simdf64_loadu(emissionBeg + i)));
+            }
+            double fromForeground = sumLanes(fromForegroundVec);
+            for (; i < maxOffset; ++i) {
+                double f = foregroundBeg[i];
+                fromForeground += f;
+                foregroundBeg[i] = (b * b2fBeg[i] + f * f2f0) * emissionBeg[i];
+            }
+
+            backgroundProb = b * b2b + fromForeground * f2b;
+        }
 
+        void calcForwardTransitionAndEmissionProbsScalar() {
             double b = backgroundProb;
             double fromForeground = 0;
             double *foregroundBeg = BEG(foregroundProbs);
@@ -328,7 +427,37 @@ namespace tantan {
                 calcBackwardTransitionProbsWithGaps();
                 return;
             }
+            if (isVectorized == false) {
+                calcEmissionAndBackwardTransitionProbsScalar();
+                return;
+            }
+
+            double toBackground = f2b * backgroundProb;
+            double *foregroundBeg = BEG(foregroundProbs);
+            const double *b2fBeg = BEG(b2fProbs);
+            int maxOffset = maxOffsetInTheSequence();
+            const double *emissionBeg = currentEmissionProbs();
+
+            simd_double toBackgroundVec = simdf64_set(toBackground);
+            simd_double f2f0Vec = simdf64_set(f2f0);
+            simd_double toForegroundVec = simdf64_setzero(0);
+            int i = 0;
+            for (; i + VECSIZE_DOUBLE <= maxOffset; i += VECSIZE_DOUBLE) {
+                simd_double f = simdf64_mul(simdf64_loadu(foregroundBeg + i), simdf64_loadu(emissionBeg + i));
+                toForegroundVec = simdf64_add(toForegroundVec, simdf64_mul(simdf64_loadu(b2fBeg + i), f));
+                simdf64_storeu(foregroundBeg + i, simdf64_add(toBackgroundVec, simdf64_mul(f2f0Vec, f)));
+            }
+            double toForeground = sumLanes(toForegroundVec);
+            for (; i < maxOffset; ++i) {
+                double f = foregroundBeg[i] * emissionBeg[i];
+                toForeground += b2fBeg[i] * f;
+                foregroundBeg[i] = toBackground + f2f0 * f;
+            }
+
+            backgroundProb = b2b * backgroundProb + toForeground;
+        }
 
+        void calcEmissionAndBackwardTransitionProbsScalar() {
             double toBackground = f2b * backgroundProb;
             double toForeground = 0;
             double *foregroundBeg = BEG(foregroundProbs);
@@ -463,10 +592,11 @@ namespace tantan {
                           double repeatOffsetProbDecay,
                           double firstGapProb,
                           double otherGapProb,
-                          float *probabilities) {
+                          float *probabilities,
+                          bool vectorized) {
         Tantan tantan(seqBeg, seqEnd, maxRepeatOffset, likelihoodRatioMatrix,
                       repeatProb, repeatEndProb, repeatOffsetProbDecay,
-                      firstGapProb, otherGapProb);
+                      firstGapProb, otherGapProb, vectorized);
         tantan.calcRepeatProbs(probabilities);
     }
 
@@ -499,7 +629,7 @@ namespace tantan {
                           double *transitionCounts) {
         Tantan tantan(seqBeg, seqEnd, maxRepeatOffset, likelihoodRatioMatrix,
                       repeatProb, repeatEndProb, repeatOffsetProbDecay,
-                      firstGapProb, otherGapProb);
+                      firstGapProb, otherGapProb, true);
         tantan.countTransitions(transitionCounts);
     }
 
@@ -81,6 +81,9 @@ int maskSequences(char *seqBeg,
 // The following routine gets the posterior probability that each
 // letter is repetitive.  It stores the results in "probabilities",
 // which must point to enough pre-allocated space to fit the results.
+// Without indels, the sums over the repeat offsets are vectorized, which
+// changes the order of the additions.  With vectorized = false they are
+// computed one offset at a time, as in the original tantan.
 
 void getProbabilities(const char *seqBeg,
                       const char *seqEnd,
@@ -91,7 +94,8 @@ void getProbabilities(const char *seqBeg,
                       double repeatOffsetProbDecay,
                       double firstGapProb,
                       double otherGapProb,
-                      float *probabilities);
+                      float *probabilities,
+                      bool vectorized = true);
 
 // The following routine masks each letter whose corresponding entry
 // in "probabilities" is >= minMaskProb.
@@ -1,4 +1,5 @@
 #include "CacheFriendlyOperations.h"
+#include "HugePageAllocator.h"
 #include "Util.h"
 
 #include <cmath>
@@ -9,9 +10,9 @@ CacheFriendlyOperations<BINSIZE>::CacheFriendlyOperations(size_t maxElement, siz
     size_t size = pow(2, ceil(log(maxElement)/log(2)));
     size = std::max(size >> MASK_0_5_BIT, (size_t) 1); // space needed in bit array
     duplicateBitArraySize = size;
-    duplicateBitArray = new(std::nothrow) unsigned char[size];
+    // the bit array and the bins are accessed at random positions, so they are backed by huge pages
+    duplicateBitArray = HugePageAllocator::allocateArray<unsigned char>(size);
     Util::checkAllocation(duplicateBitArray, "Cannot allocate duplicateBitArray memory in CacheFriendlyOperations");
-    memset(duplicateBitArray, 0, duplicateBitArraySize * sizeof(unsigned char));
 
     // find nearest upper power of 2^(x)
     initBinSize = pow(2, ceil(log(initBinSize)/log(2)));
@@ -22,14 +23,14 @@ CacheFriendlyOperations<BINSIZE>::CacheFriendlyOperations(size_t maxElement, siz
     bins = new(std::nothrow) CounterResult*[BINCOUNT];
     Util::checkAllocation(bins, "Cannot allocate bins memory in CacheFriendlyOperations");
 
-    binDataFrame = new(std::nothrow) CounterResult[BINCOUNT * binSize];
+    binDataFrame = HugePageAllocator::allocateArray<CounterResult>(BINCOUNT * binSize);
     Util::checkAllocation(binDataFrame, "Cannot allocate binDataFrame memory in CacheFriendlyOperations");
 }
 
 template<unsigned int BINSIZE>
 CacheFriendlyOperations<BINSIZE>::~CacheFriendlyOperations<BINSIZE>(){
-    delete[] duplicateBitArray;
-    delete[] binDataFrame;
+    HugePageAllocator::deallocateArray(duplicateBitArray, duplicateBitArraySize);
+    HugePageAllocator::deallocateArray(binDataFrame, BINCOUNT * binSize);
     delete[] tmpElementBuffer;
     delete[] bins;
 }
@@ -80,7 +81,6 @@ template<unsigned int BINSIZE>
 size_t CacheFriendlyOperations<BINSIZE>::mergeDiagonalDuplicates(CounterResult *output) {
     size_t doubleElementCount = 0;
     const CounterResult *bin_ref_pointer = binDataFrame;
-    // duplicateBitArray is already zero'd from findDuplicates
 
     for (size_t bin = 0; bin < BINCOUNT; bin++) {
         const CounterResult *binStartPos = (bin_ref_pointer + bin * binSize);
@@ -105,6 +105,7 @@ size_t CacheFriendlyOperations<BINSIZE>::mergeDiagonalDuplicates(CounterResult *
 
             duplicateBitArray[hashBinElement] = static_cast<unsigned char>(element.diagonal);
         }
+        clearBinElements(binStartPos, currBinSize);
     }
     return doubleElementCount;
 }
@@ -113,7 +114,6 @@ template<unsigned int BINSIZE>
 size_t CacheFriendlyOperations<BINSIZE>::mergeScoreDuplicates(CounterResult *output) {
     size_t doubleElementCount = 0;
     const CounterResult *bin_ref_pointer = binDataFrame;
-    // duplicateBitArray is already zero'd from findDuplicates
 
     for (size_t bin = 0; bin < BINCOUNT; bin++) {
         const CounterResult *binStartPos = (bin_ref_pointer + bin * binSize);
@@ -138,13 +138,13 @@ size_t CacheFriendlyOperations<BINSIZE>::mergeScoreDuplicates(CounterResult *out
             doubleElementCount += (UNLIKELY(duplicateBitArray[hashBinElement] != 0  ) ) ? 1 : 0;
             duplicateBitArray[hashBinElement] = static_cast<unsigned char>(binStartPos[n].diagonal);
         }
+        clearBinElements(binStartPos, currBinSize);
     }
     return doubleElementCount;
 }
 
 template<unsigned int BINSIZE>
 size_t CacheFriendlyOperations<BINSIZE>::findDuplicates(CounterResult *output, size_t outputSize, bool computeTotalScore) {
-    memset(duplicateBitArray, 0, duplicateBitArraySize * sizeof(unsigned char));
     size_t doubleElementCount = 0;
     const CounterResult *bin_ref_pointer = binDataFrame;
     for (size_t bin = 0; bin < BINCOUNT; bin++) {
@@ -169,6 +169,7 @@ size_t CacheFriendlyOperations<BINSIZE>::findDuplicates(CounterResult *output, s
         }
         // check for overflow
         if (doubleElementCount + elementCount >= outputSize) {
+            clearBinElements(binStartPos, currBinSize);
             return doubleElementCount;
         }
         // set memory to zero
@@ -221,19 +222,24 @@ size_t CacheFriendlyOperations<BINSIZE>::findDuplicates(CounterResult *output, s
                 duplicateBitArray[hashBinElement] = static_cast<unsigned char>(tmpElementBuffer[n].diagonal);
             }
         }
-        // clean memory faster if current bin size is smaller duplicateBitArraySize
-        if (currBinSize < duplicateBitArraySize/16) {
-            for (size_t n = 0; n < currBinSize; n++) {
-                const unsigned int byteArrayPos = binStartPos[n].id >> (MASK_0_5_BIT);
-                duplicateBitArray[byteArrayPos] = 0;
-            }
-        } else {
-            memset(duplicateBitArray, 0, duplicateBitArraySize * sizeof(unsigned char));
-        }
+        clearBinElements(binStartPos, currBinSize);
     }
     return doubleElementCount;
 }
 
+template<unsigned int BINSIZE>
+void CacheFriendlyOperations<BINSIZE>::clearBinElements(const CounterResult *binStartPos, size_t currBinSize) {
+    // clean memory faster if current bin size is smaller duplicateBitArraySize
+    if (currBinSize < duplicateBitArraySize/16) {
+        for (size_t n = 0; n < currBinSize; n++) {
+            const unsigned int byteArrayPos = binStartPos[n].id >> (MASK_0_5_BIT);
+            duplicateBitArray[byteArrayPos] = 0;
+        }
+    } else {
+        memset(duplicateBitArray, 0, duplicateBitArraySize * sizeof(unsigned char));
+    }
+}
+
 template<unsigned int BINSIZE>
 bool CacheFriendlyOperations<BINSIZE>::checkForOverflowAndResizeArray(bool includeTmpResult) {
     const CounterResult *bin_ref_pointer = binDataFrame;
@@ -248,12 +254,11 @@ bool CacheFriendlyOperations<BINSIZE>::checkForOverflowAndResizeArray(bool inclu
             // overflow detected
             // find nearest upper power of 2^(x)
 //            std::cout << "Found overlow " << n << std::endl;
+            HugePageAllocator::deallocateArray(binDataFrame, BINCOUNT * binSize);
             binSize = pow(2, ceil(log(binSize + 1)/log(2)));
 
-            delete[] binDataFrame;
-            binDataFrame = new(std::nothrow) CounterResult[BINCOUNT * binSize];
+            binDataFrame = HugePageAllocator::allocateArray<CounterResult>(BINCOUNT * binSize);
             Util::checkAllocation(binDataFrame, "Cannot reallocate reallocBinMemory in CacheFriendlyOperations");
-            memset(binDataFrame, 0, sizeof(CounterResult) * binSize * BINCOUNT);
 
             if (includeTmpResult) {
                 delete[] tmpElementBuffer;
@@ -311,7 +316,6 @@ template<unsigned int BINSIZE>
 size_t CacheFriendlyOperations<BINSIZE>::keepMaxElement(CounterResult *output) {
     size_t doubleElementCount = 0;
     const CounterResult *bin_ref_pointer = binDataFrame;
-    memset(duplicateBitArray, 0, duplicateBitArraySize * sizeof(unsigned char));
     for (size_t bin = 0; bin < BINCOUNT; bin++) {
         const CounterResult *binStartPos = (bin_ref_pointer + bin * binSize);
         const size_t currBinSize = (bins[bin] - binStartPos);
@@ -336,6 +340,7 @@ size_t CacheFriendlyOperations<BINSIZE>::keepMaxElement(CounterResult *output) {
             doubleElementCount += found;
             duplicateBitArray[hashBinElement] = duplicateBitArray[hashBinElement] * (1 - found);
         }
+        // the byte of each id was reset at its element with the maximum count
     }
     return doubleElementCount;
 }
@@ -80,6 +80,8 @@ public:
 
 private:
     // this bit array should fit in L1/L2
+    // it is zero between calls: each operation resets the bytes of the elements it hashed,
+    // so the cost of a call depends on its number of elements and not on the database size
     size_t duplicateBitArraySize;
     unsigned char *duplicateBitArray;
     // needed for lower bit hashing function
@@ -118,6 +120,9 @@ private:
     size_t mergeDiagonalDuplicates(CounterResult *output);
 
     size_t keepMaxElement(CounterResult *output);
+
+    // reset the bytes of the elements of a bin in duplicateBitArray
+    void clearBinElements(const CounterResult *binStartPos, size_t currBinSize);
 };
 
 #undef BITS_TO_REPRESENT
@@ -53,7 +53,7 @@ public:
 void IndexBuilder::fillDatabase(IndexTable *indexTable, SequenceLookup **maskedLookup,
                                 SequenceLookup **unmaskedLookup,BaseMatrix &subMat, Sequence *seq,
                                 DBReader<unsigned int> *dbr, size_t dbFrom, size_t dbTo, int kmerThr,
-                                bool mask, bool maskLowerCaseMode) {
+                                bool mask, bool maskLowerCaseMode, bool compressEntries) {
     Debug(Debug::INFO) << "Index table: counting k-mers\n";
 
     const bool isProfile = Parameters::isEqualDbtype(seq->getSeqType(), Parameters::DBTYPE_HMM_PROFILE);
@@ -204,53 +204,77 @@ void IndexBuilder::fillDatabase(IndexTable *indexTable, SequenceLookup **maskedL
 //    Debug(Debug::INFO) << "Index table: Remove "<< lowSelectiveResidues <<" none selective residues\n";
 //    Debug(Debug::INFO) << "Index table: init... from "<< dbFrom << " to "<< dbTo << "\n";
 
-    indexTable->initMemory(info->tableSize);
+    if (compressEntries) {
+        indexTable->initCompressedMemory(info->tableSize);
+    } else {
+        indexTable->initMemory(info->tableSize);
+    }
     indexTable->init();
 
     delete info;
-    Debug::Progress progress2(dbTo-dbFrom);
 
-    Debug(Debug::INFO) << "Index table: fill\n";
-    #pragma omp parallel
-    {
-        unsigned int thread_idx = 0;
+    // a compressed table is filled in one pass over the sequences per range of k-mers,
+    // so that only the entries of one range are kept uncompressed
+    const size_t rangeSize = IndexTable::getCompressionRangeSize(indexTable->getTableEntriesNum());
+    size_t kmerFrom = 0;
+    while (kmerFrom < indexTable->getTableSize()) {
+        size_t kmerTo = indexTable->getTableSize();
+        if (compressEntries) {
+            kmerTo = indexTable->initFillRange(kmerFrom, rangeSize);
+            Debug(Debug::INFO) << "Index table: fill k-mers " << kmerFrom << " to " << kmerTo << "\n";
+        } else {
+            Debug(Debug::INFO) << "Index table: fill\n";
+        }
+        Debug::Progress progress2(dbTo-dbFrom);
+
+        #pragma omp parallel
+        {
+            unsigned int thread_idx = 0;
 #ifdef OPENMP
-        thread_idx = static_cast<unsigned int>(omp_get_thread_num());
+            thread_idx = static_cast<unsigned int>(omp_get_thread_num());
 #endif
-        Sequence s(seq->getMaxLen(), seq->getSeqType(), &subMat, seq->getKmerSize(), seq->isSpaced(), false, true, seq->getUserSpacedKmerPattern());
-        Indexer idxer(static_cast<unsigned int>(indexTable->getAlphabetSize()), seq->getKmerSize());
-        IndexEntryLocalTmp *buffer = static_cast<IndexEntryLocalTmp *>(malloc( seq->getMaxLen() * sizeof(IndexEntryLocalTmp)));
-        size_t bufferSize = seq->getMaxLen();
-        KmerGenerator *generator = NULL;
-        if (isProfile) {
-            generator = new KmerGenerator(seq->getKmerSize(), indexTable->getAlphabetSize(), kmerThr);
-            generator->setDivideStrategy(s.profile_matrix);
-        }
+            Sequence s(seq->getMaxLen(), seq->getSeqType(), &subMat, seq->getKmerSize(), seq->isSpaced(), false, true, seq->getUserSpacedKmerPattern());
+            Indexer idxer(static_cast<unsigned int>(indexTable->getAlphabetSize()), seq->getKmerSize());
+            IndexEntryLocalTmp *buffer = static_cast<IndexEntryLocalTmp *>(malloc( seq->getMaxLen() * sizeof(IndexEntryLocalTmp)));
+            size_t bufferSize = seq->getMaxLen();
+            KmerGenerator *generator = NULL;
+            if (isProfile) {
+                generator = new KmerGenerator(seq->getKmerSize(), indexTable->getAlphabetSize(), kmerThr);
+                generator->setDivideStrategy(s.profile_matrix);
+            }
 
-        #pragma omp for schedule(dynamic, 100)
-        for (size_t id = dbFrom; id < dbTo; id++) {
-            s.resetCurrPos();
-            progress2.updateProgress();
+            #pragma omp for schedule(dynamic, 100)
+            for (size_t id = dbFrom; id < dbTo; id++) {
+                s.resetCurrPos();
+                progress2.updateProgress();
+
+                unsigned int qKey = dbr->getDbKey(id);
+                if (isProfile) {
+                    s.mapSequence(id - dbFrom, qKey, dbr->getData(id, thread_idx), dbr->getSeqLen(id));
+                    indexTable->addSimilarSequence(&s, generator, &buffer, bufferSize, &idxer);
+                } else {
+                    s.mapSequence(id - dbFrom, qKey, sequenceLookup->getSequence(id - dbFrom));
+                    indexTable->addSequence(&s, &idxer, &buffer, bufferSize, kmerThr, idScoreLookup);
+                }
+            }
 
-            unsigned int qKey = dbr->getDbKey(id);
-            if (isProfile) {
-                s.mapSequence(id - dbFrom, qKey, dbr->getData(id, thread_idx), dbr->getSeqLen(id));
-                indexTable->addSimilarSequence(&s, generator, &buffer, bufferSize, &idxer);
-            } else {
-                s.mapSequence(id - dbFrom, qKey, sequenceLookup->getSequence(id - dbFrom));
-                indexTable->addSequence(&s, &idxer, &buffer, bufferSize, kmerThr, idScoreLookup);
+            if (generator != NULL) {
+                delete generator;
             }
-        }
 
-        if (generator != NULL) {
-            delete generator;
+            free(buffer);
         }
 
-        free(buffer);
+        if (compressEntries) {
+            indexTable->compressFillRange();
+        }
+        kmerFrom = kmerTo;
     }
     if(idScoreLookup!=NULL){
         delete[] idScoreLookup;
     }
-    indexTable->revertPointer();
-    indexTable->sortDBSeqLists();
+    if (compressEntries == false) {
+        indexTable->revertPointer();
+        indexTable->sortDBSeqLists();
+    }
 }
@@ -17,8 +17,10 @@
 #include "KmerGenerator.h"
 #include "Parameters.h"
 #include "FastSort.h"
+#include "HugePageAllocator.h"
 #include <stdlib.h>
 #include <algorithm>
+#include <vector>
 
 // IndexEntryLocal is an entry with position and seqId for a kmer
 // structure needs to be packed or it will need 8 bytes instead of 6
@@ -67,11 +69,13 @@ public:
     IndexTable(int alphabetSize, int kmerSize, bool externalData)
             : tableSize(MathUtil::ipow<size_t>(alphabetSize, kmerSize)), alphabetSize(alphabetSize),
               kmerSize(kmerSize), externalData(externalData), tableEntriesNum(0), size(0),
-              indexer(new Indexer(alphabetSize, kmerSize)), entries(NULL), offsets(NULL) {
+              indexer(new Indexer(alphabetSize, kmerSize)), entries(NULL), offsets(NULL),
+              compressed(false), compressedEntries(NULL), compressedEntriesSize(0),
+              fillKmerFrom(0), fillKmerTo(tableSize), fillEntriesBase(0) {
         if (externalData == false) {
-            offsets = new(std::nothrow) size_t[tableSize + 1];
+            // k-mer lookups hit random offsets and entries, so both are backed by huge pages
+            offsets = HugePageAllocator::allocateArray<size_t>(tableSize + 1);
             Util::checkAllocation(offsets, "Can not allocate entries memory in IndexTable");
-            memset(offsets, 0, (tableSize + 1) * sizeof(size_t));
         }
     }
 
@@ -83,13 +87,17 @@ public:
     void deleteEntries() {
         if (externalData == false) {
             if (entries != NULL) {
-                delete[] entries;
+                HugePageAllocator::deallocateArray(entries, tableEntriesNum);
                 entries = NULL;
             }
             if (offsets != NULL) {
-                delete[] offsets;
+                HugePageAllocator::deallocateArray(offsets, tableSize + 1);
                 offsets = NULL;
             }
+            if (compressedEntries != NULL) {
+                HugePageAllocator::deallocate(compressedEntries, compressedEntriesSize);
+                compressedEntries = NULL;
+            }
         }
     }
 
@@ -176,6 +184,54 @@ public:
         return (entries + offsets[kmer]);
     }
 
+    // upper bound of the list size of a k-mer, exact for uncompressed tables
+    // a compressed entry needs at least three bytes
+    inline size_t getDBSeqListMaxSize(size_t kmer) {
+        const size_t diff = offsets[kmer + 1] - offsets[kmer];
+        return compressed ? diff / 3 : diff;
+    }
+
+    // list size of a k-mer, compressed lists are scanned for it
+    size_t getDBSeqListSize(size_t kmer) {
+        if (compressed == false) {
+            return offsets[kmer + 1] - offsets[kmer];
+        }
+        const unsigned char *data = compressedEntries + offsets[kmer];
+        const unsigned char *end = compressedEntries + offsets[kmer + 1];
+        size_t count = 0;
+        while (data < end) {
+            while (*data & 0x80) {
+                data++;
+            }
+            data += 1 + sizeof(unsigned short);
+            count++;
+        }
+        return count;
+    }
+
+    // writes the list of a k-mer to output (decoded for compressed tables), returns its size
+    inline size_t copyDBSeqList(size_t kmer, IndexEntryLocal *output) {
+        if (compressed == false) {
+            const size_t size = offsets[kmer + 1] - offsets[kmer];
+            memcpy(output, entries + offsets[kmer], sizeof(IndexEntryLocal) * size);
+            return size;
+        }
+        const unsigned char *data = compressedEntries + offsets[kmer];
+        const unsigned char *end = compressedEntries + offsets[kmer + 1];
+        IndexEntryLocal *entry = output;
+        unsigned int seqId = 0;
+        while (data < end) {
+            seqId += readVarint(data);
+            unsigned short position;
+            memcpy(&position, data, sizeof(unsigned short));
+            data += sizeof(unsigned short);
+            entry->seqId = seqId;
+            entry->position_j = position;
+            entry++;
+        }
+        return entry - output;
+    }
+
     void sortDBSeqLists() {
         #pragma omp parallel for
         for (size_t i = 0; i < tableSize; i++) {
@@ -198,6 +254,119 @@ public:
         return offsets;
     }
 
+    // compressed tables keep each k-mer list as sequence id deltas (varbyte) and positions,
+    // their offsets are byte offsets into the compressed entries
+    bool isCompressed() {
+        return compressed;
+    }
+
+    unsigned char *getCompressedEntries() {
+        return compressedEntries;
+    }
+
+    size_t getCompressedEntriesSize() {
+        return compressedEntriesSize;
+    }
+
+    // a compressed table is filled in ranges of k-mers, only the entries of the current range are kept uncompressed
+    void initCompressedMemory(size_t dbSize) {
+        size_t tableEntriesNum = 0;
+        for (size_t i = 0; i < getTableSize(); i++) {
+            tableEntriesNum += getOffset(i);
+        }
+        this->tableEntriesNum = tableEntriesNum;
+        this->size = dbSize;
+        compressed = true;
+    }
+
+    // allocates the entries of the next range of k-mers, which starts at kmerFrom and has at most maxEntries
+    // entries unless its first k-mer has more, returns the end of the range
+    size_t initFillRange(size_t kmerFrom, size_t maxEntries) {
+        size_t kmerTo = kmerFrom + 1;
+        while (kmerTo < tableSize && offsets[kmerTo + 1] - offsets[kmerFrom] <= maxEntries) {
+            kmerTo++;
+        }
+        fillKmerFrom = kmerFrom;
+        fillKmerTo = kmerTo;
+        fillEntriesBase = offsets[kmerFrom];
+        const size_t rangeEntries = offsets[kmerTo] - fillEntriesBase;
+        entries = HugePageAllocator::allocateArray<IndexEntryLocal>(rangeEntries);
+        Util::checkAllocation(entries, "Can not allocate " + SSTR(rangeEntries * sizeof(IndexEntryLocal)) + " bytes for entries in IndexTable::initFillRange");
+        return kmerTo;
+    }
+
+    // sorts the lists of the filled range and appends them to the compressed entries
+    void compressFillRange() {
+        const size_t rangeEntries = offsets[fillKmerTo] - fillEntriesBase;
+        // filling moved each offset of the range to the start of the next k-mer
+        for (size_t i = fillKmerTo - 1; i > fillKmerFrom; i--) {
+            offsets[i] = offsets[i - 1];
+        }
+        offsets[fillKmerFrom] = fillEntriesBase;
+
+        #pragma omp parallel for
+        for (size_t i = fillKmerFrom; i < fillKmerTo; i++) {
+            IndexEntryLocal *list = entries + (offsets[i] - fillEntriesBase);
+            SORT_SERIAL(list, list + (offsets[i + 1] - offsets[i]), IndexEntryLocal::comapreByIdAndPos);
+        }
+
+        // the byte offsets of a block of k-mers replace their entry offsets once the block is encoded
+        const size_t blockSize = 1024 * 1024;
+        std::vector<size_t> byteOffsets(std::min(blockSize, fillKmerTo - fillKmerFrom) + 1);
+        for (size_t blockFrom = fillKmerFrom; blockFrom < fillKmerTo; blockFrom += blockSize) {
+            const size_t blockTo = std::min(blockFrom + blockSize, fillKmerTo);
+            #pragma omp parallel for
+            for (size_t i = blockFrom; i < blockTo; i++) {
+                const IndexEntryLocal *list = entries + (offsets[i] - fillEntriesBase);
+                byteOffsets[i - blockFrom + 1] = getCompressedListSize(list, offsets[i + 1] - offsets[i]);
+            }
+            byteOffsets[0] = compressedEntriesSize;
+            for (size_t i = 1; i <= blockTo - blockFrom; i++) {
+                byteOffsets[i] += byteOffsets[i - 1];
+            }
+            const size_t newSize = byteOffsets[blockTo - blockFrom];
+            if (newSize > compressedEntriesSize) {
+                unsigned char *newEntries = static_cast<unsigned char *>(HugePageAllocator::reallocate(compressedEntries, compressedEntriesSize, newSize));
+                Util::checkAllocation(newEntries, "Can not allocate " + SSTR(newSize) + " bytes for compressed entries in IndexTable::compressFillRange");
+                compressedEntries = newEntries;
+                compressedEntriesSize = newSize;
+            }
+            #pragma omp parallel for
+            for (size_t i = blockFrom; i < blockTo; i++) {
+                const IndexEntryLocal *list = entries + (offsets[i] - fillEntriesBase);
+                compressList(list, offsets[i + 1] - offsets[i], compressedEntries + byteOffsets[i - blockFrom]);
+            }
+            for (size_t i = blockFrom; i < blockTo; i++) {
+                offsets[i] = byteOffsets[i - blockFrom];
+            }
+        }
+        if (fillKmerTo == tableSize) {
+            offsets[tableSize] = compressedEntriesSize;
+        }
+
+        HugePageAllocator::deallocateArray(entries, rangeEntries);
+        entries = NULL;
+        fillKmerFrom = 0;
+        fillKmerTo = tableSize;
+        fillEntriesBase = 0;
+    }
+
+    // entries kept uncompressed while a compressed table is filled
+    static size_t getCompressionRangeSize(size_t tableEntriesNum) {
+        return std::max(tableEntriesNum / 4, static_cast<size_t>(64 * 1024 * 1024));
+    }
+
+    // bytes per compressed entry, estimated from the mean distance of the sequence ids in a k-mer list
+    static double estimateCompressedEntrySize(size_t sequenceCount, size_t tableEntriesNum, size_t tableSize) {
+        const double entriesPerKmer = std::max(static_cast<double>(tableEntriesNum) / static_cast<double>(tableSize), 1.0);
+        const double meanDistance = static_cast<double>(sequenceCount) / entriesPerKmer;
+        size_t varintSize = 1;
+        while (varintSize < 5 && meanDistance >= static_cast<double>(1ULL << (7 * varintSize))) {
+            varintSize++;
+        }
+        return static_cast<double>(varintSize + sizeof(unsigned short));
+    }
+
     // init the arrays for the sequence lists
     void initMemory(size_t dbSize) {
         size_t tableEntriesNum = 0;
@@ -209,7 +378,7 @@ public:
         this->size = dbSize; // amount of sequences added
 
         // allocate memory for the sequence id lists
-        entries = new(std::nothrow) IndexEntryLocal[tableEntriesNum];
+        entries = HugePageAllocator::allocateArray<IndexEntryLocal>(tableEntriesNum);
         Util::checkAllocation(entries, "Can not allocate entries memory in IndexTable::initMemory");
     }
 
@@ -234,12 +403,35 @@ public:
         this->offsets = entryOffsets;
     }
 
+    void initCompressedTableByExternalData(size_t sequenceCount, size_t tableEntriesNum, unsigned char *compressedEntries, size_t *entryOffsets) {
+        this->tableEntriesNum = tableEntriesNum;
+        this->size = sequenceCount;
+        this->compressed = true;
+
+        this->compressedEntries = compressedEntries;
+        this->compressedEntriesSize = entryOffsets[tableSize];
+        this->offsets = entryOffsets;
+    }
+
+    void initCompressedTableByExternalDataCopy(size_t sequenceCount, size_t tableEntriesNum, unsigned char *compressedEntries, size_t *entryOffsets) {
+        this->tableEntriesNum = tableEntriesNum;
+        this->size = sequenceCount;
+        this->compressed = true;
+
+        this->compressedEntriesSize = entryOffsets[tableSize];
+        this->compressedEntries = HugePageAllocator::allocateArray<unsigned char>(compressedEntriesSize);
+        Util::checkAllocation(this->compressedEntries, "Can not allocate " + SSTR(compressedEntriesSize) + " bytes for compressed entries in IndexTable::initCompressedTableByExternalDataCopy");
+        memcpy(this->compressedEntries, compressedEntries, compressedEntriesSize);
+
+        memcpy(this->offsets, entryOffsets, (tableSize + 1) * sizeof(size_t));
+    }
+
     void initTableByExternalDataCopy(size_t sequenceCount, size_t tableEntriesNum, IndexEntryLocal *entries, size_t *entryOffsets) {
         this->tableEntriesNum = tableEntriesNum;
         this->size = sequenceCount;
 
-        this->entries = new(std::nothrow) IndexEntryLocal[tableEntriesNum];
-        Util::checkAllocation(entries, "Can not allocate " + SSTR(tableEntriesNum * sizeof(IndexEntryLocal)) + " bytes for entries in IndexTable::initMemory");
+        this->entries = HugePageAllocator::allocateArray<IndexEntryLocal>(tableEntriesNum);
+        Util::checkAllocation(this->entries, "Can not allocate " + SSTR(tableEntriesNum * sizeof(IndexEntryLocal)) + " bytes for entries in IndexTable::initMemory");
         memcpy(this->entries, entries, tableEntriesNum * sizeof(IndexEntryLocal));
 
         memcpy(this->offsets, entryOffsets, (tableSize + 1) * sizeof(size_t));
@@ -263,7 +455,7 @@ public:
         size_t minKmer = 0;
         size_t emptyKmer = 0;
         for (size_t i = 0; i < tableSize; i++) {
-            const ptrdiff_t size = offsets[i + 1] - offsets[i];
+            const ptrdiff_t size = getDBSeqListSize(i);
             minKmer = std::min(minKmer, (size_t) size);
             entrySize += size;
             if (size == 0) {
@@ -283,7 +475,11 @@ public:
         double avgKmer = ((double) entrySize) / ((double) tableSize);
         Debug(Debug::INFO) << "Index statistics\n";
         Debug(Debug::INFO) << "Entries:          " << entrySize << "\n";
-        Debug(Debug::INFO) << "DB size:          " << (entrySize * sizeof(IndexEntryLocal) + tableSize * sizeof(size_t))/1024/1024 << " MB\n";
+        const size_t entriesBytes = compressed ? compressedEntriesSize : entrySize * sizeof(IndexEntryLocal);
+        Debug(Debug::INFO) << "DB size:          " << (entriesBytes + tableSize * sizeof(size_t))/1024/1024 << " MB\n";
+        if (compressed) {
+            Debug(Debug::INFO) << "Compressed entry: " << static_cast<double>(compressedEntriesSize) / std::max(entrySize, static_cast<size_t>(1)) << " bytes\n";
+        }
         Debug(Debug::INFO) << "Avg k-mer size:   " << avgKmer << "\n";
         Debug(Debug::INFO) << "Top " << top_N << " k-mers\n";
         for (size_t j = 0; j < top_N; j++) {
@@ -310,6 +506,9 @@ public:
             for(size_t i = 0; i < scoreMatrix.second; i++) {
                 unsigned int kmerIdx = scoreMatrix.first[i];
 
+                // k-mers outside of the range that is currently filled are added in another pass
+                if (kmerIdx < fillKmerFrom || kmerIdx >= fillKmerTo)
+                    continue;
                 // if region got masked do not add kmer
                 if (offsets[kmerIdx + 1] - offsets[kmerIdx] == 0)
                     continue;
@@ -329,7 +528,7 @@ public:
             unsigned int kmerIdx = (*buffer)[pos].kmer;
             if(kmerIdx != prevKmer){
                 size_t offset = __sync_fetch_and_add(&(offsets[kmerIdx]), 1);
-                IndexEntryLocal *entry = &entries[offset];
+                IndexEntryLocal *entry = &entries[offset - fillEntriesBase];
                 entry->seqId      = (*buffer)[pos].seqId;
                 entry->position_j = (*buffer)[pos].position_j;
             }
@@ -362,6 +561,9 @@ public:
                 }
             }
             unsigned int kmerIdx = idxer->int2index(kmer, 0, kmerSize);
+            // k-mers outside of the range that is currently filled are added in another pass
+            if (kmerIdx < fillKmerFrom || kmerIdx >= fillKmerTo)
+                continue;
             // if region got masked do not add kmer
             if (offsets[kmerIdx + 1] - offsets[kmerIdx] == 0)
                 continue;
@@ -385,7 +587,7 @@ public:
             unsigned int kmerIdx = (*buffer)[pos].kmer;
             if(kmerIdx != prevKmer){
                 size_t offset = __sync_fetch_and_add(&(offsets[kmerIdx]), 1);
-                IndexEntryLocal *entry = &entries[offset];
+                IndexEntryLocal *entry = &entries[offset - fillEntriesBase];
                 entry->seqId      = (*buffer)[pos].seqId;
                 entry->position_j = (*buffer)[pos].position_j;
             }
@@ -401,8 +603,9 @@ public:
                 indexer->printKmer(i, kmerSize, num2aa);
 
                 Debug(Debug::INFO) << "\n";
-                IndexEntryLocal *e = &entries[offsets[i]];
-                for (ptrdiff_t j = 0; j < entrySize; j++) {
+                std::vector<IndexEntryLocal> e(getDBSeqListSize(i));
+                copyDBSeqList(i, e.data());
+                for (size_t j = 0; j < e.size(); j++) {
                     Debug(Debug::INFO) << "\t(" << e[j].seqId << ", " << e[j].position_j << ")\n";
                 }
             }
@@ -478,6 +681,57 @@ protected:
     IndexEntryLocal *entries;
     size_t *offsets;
 
+    bool compressed;
+    unsigned char *compressedEntries;
+    size_t compressedEntriesSize;
+
+    // range of k-mers that is filled, entries holds the entries of this range only
+    size_t fillKmerFrom;
+    size_t fillKmerTo;
+    size_t fillEntriesBase;
+
+    static inline unsigned int readVarint(const unsigned char *&data) {
+        unsigned int value = *data & 0x7F;
+        unsigned int shift = 7;
+        while (*data++ & 0x80) {
+            value |= static_cast<unsigned int>(*data & 0x7F) << shift;
+            shift += 7;
+        }
+        return value;
+    }
+
+    static size_t getCompressedListSize(const IndexEntryLocal *list, size_t size) {
+        size_t bytes = 0;
+        unsigned int prevSeqId = 0;
+        for (size_t i = 0; i < size; i++) {
+            unsigned int delta = list[i].seqId - prevSeqId;
+            bytes += 1 + sizeof(unsigned short);
+            while (delta >= 0x80) {
+                delta >>= 7;
+                bytes++;
+            }
+            prevSeqId = list[i].seqId;
+        }
+        return bytes;
+    }
+
+    // the lists are sorted by sequence id, so the deltas are small for large k-mer lists
+    static void compressList(const IndexEntryLocal *list, size_t size, unsigned char *data) {
+        unsigned int prevSeqId = 0;
+        for (size_t i = 0; i < size; i++) {
+            unsigned int delta = list[i].seqId - prevSeqId;
+            while (delta >= 0x80) {
+                *data++ = static_cast<unsigned char>(delta | 0x80);
+                delta >>= 7;
+            }
+            *data++ = static_cast<unsigned char>(delta);
+            const unsigned short position = list[i].position_j;
+            memcpy(data, &position, sizeof(unsigned short));
+            data += sizeof(unsigned short);
+            prevSeqId = list[i].seqId;
+        }
+    }
+
     // sequence lookup
     SequenceLookup *sequenceLookup;
 };
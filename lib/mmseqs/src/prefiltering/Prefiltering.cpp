@@ -81,6 +81,7 @@ Prefiltering::Prefiltering(const std::string &queryDB,
             EXIT(EXIT_FAILURE);
     }
 
+    compressKmerIndex = par.compressKmerIndex == 1;
     if (Parameters::isEqualDbtype(FileUtil::parseDbType(targetDB.c_str()), Parameters::DBTYPE_INDEX_DB)) {
         if (preloadMode == Parameters::PRELOAD_MODE_AUTO) {
             if (sensitivity > 6.0) {
@@ -155,6 +156,7 @@ Prefiltering::Prefiltering(const std::string &queryDB,
             spacedKmer = data.spacedKmer != 0;
             spacedKmerPattern = PrefilteringIndexReader::getSpacedPattern(tidxdbr);
             seedScoringMatrixFile = MultiParam<char*>(PrefilteringIndexReader::getSubstitutionMatrix(tidxdbr));
+            compressKmerIndex = PrefilteringIndexReader::isIndexTableCompressed(tidxdbr);
         } else {
             Debug(Debug::ERROR) << "Outdated index version. Please recompute it with 'createindex'!\n";
             EXIT(EXIT_FAILURE);
@@ -181,6 +183,13 @@ Prefiltering::Prefiltering(const std::string &queryDB,
     // memoryLimit in bytes
     size_t memoryLimit=Util::computeMemory(par.splitMemoryLimit);
 
+    numaReplicate = par.numaReplicate == 1 && threads > 1 && numaTopology.getNodeCount() > 1;
+    if (numaReplicate) {
+        // node 0 uses the index table itself, every other node holds a copy
+        Debug(Debug::INFO) << "Replicating the index table on " << numaTopology.getNodeCount() << " NUMA nodes\n";
+        memoryLimit /= numaTopology.getNodeCount();
+    }
+
     if (templateDBIsIndex == false && sameQTDB == true) {
         qdbr = tdbr;
     } else {
@@ -189,10 +198,46 @@ Prefiltering::Prefiltering(const std::string &queryDB,
     }
     Debug(Debug::INFO) << "Query database size: " << qdbr->getSize() << " type: " << Parameters::getDbTypeName(querySeqType) << "\n";
 
+    // short queries (e.g. six-frame ORF fragments) can be matched in batches on request, if enough of them are in the query database
+    std::vector<size_t> queryLengthCounts;
+    size_t shortQueries = 0;
+    for (size_t id = 0; id < qdbr->getSize(); id++) {
+        const size_t seqLen = qdbr->getSeqLen(id);
+        if (seqLen >= queryLengthCounts.size()) {
+            queryLengthCounts.resize(seqLen + 1, 0);
+        }
+        queryLengthCounts[seqLen]++;
+        shortQueries += (seqLen <= QueryMatcher::BATCH_MAX_QUERY_LEN) ? 1 : 0;
+    }
+    batchShortQueries = par.batchShortQueries == 1
+                        && Parameters::isEqualDbtype(querySeqType, Parameters::DBTYPE_AMINO_ACIDS)
+                        && Parameters::isEqualDbtype(targetSeqType, Parameters::DBTYPE_NUCLEOTIDES) == false
+                        && shortQueries >= qdbr->getSize() / 4 && shortQueries > 1;
+
+    if (splitMode == Parameters::THROUGHPUT_DB_SPLIT) {
+        if (templateDBIsIndex) {
+            // the splits of a precomputed index are fixed
+            splitMode = Parameters::DETECT_BEST_DB_SPLIT;
+        } else if (planThroughputSplit(*tdbr, alphabetSize - 1, querySeqType, threads, compressKmerIndex, memoryLimit,
+                                       qdbr->getSize(), queryLengthCounts, maxResListLen, kmerSize, splits, splitMode) == false) {
+            splitMode = Parameters::DETECT_BEST_DB_SPLIT;
+        }
+    }
+
     setupSplit(*tdbr, alphabetSize - 1, querySeqType,
-               threads, templateDBIsIndex, memoryLimit, qdbr->getSize(),
+               threads, templateDBIsIndex, compressKmerIndex, memoryLimit, qdbr->getSize(),
                maxResListLen, kmerSize, splits, splitMode);
 
+    if (batchShortQueries) {
+        size_t memoryNeeded = estimateMemoryConsumption((splitMode == Parameters::TARGET_DB_SPLIT) ? splits : 1, tdbr->getSize(),
+                                                        tdbr->getAminoAcidDBSize(), maxResListLen, alphabetSize - 1, kmerSize, querySeqType, threads, compressKmerIndex)
+                              + estimateBatchMemoryConsumption((splitMode == Parameters::TARGET_DB_SPLIT) ? splits : 1, tdbr->getSize(), threads);
+        if (memoryNeeded > 0.9 * memoryLimit) {
+            Debug(Debug::INFO) << "Short queries are matched one by one, since their batches would exceed the memory limit\n";
+            batchShortQueries = false;
+        }
+    }
+
     if(Parameters::isEqualDbtype(targetSeqType, Parameters::DBTYPE_NUCLEOTIDES) == false){
         const bool isProfileSearch = Parameters::isEqualDbtype(querySeqType, Parameters::DBTYPE_HMM_PROFILE) ||
                                      Parameters::isEqualDbtype(targetSeqType, Parameters::DBTYPE_HMM_PROFILE);
@@ -228,6 +273,8 @@ Prefiltering::~Prefiltering() {
         delete qdbr;
     }
 
+    deleteIndexReplicas(nodeIndexTables, nodeSequenceLookups);
+
     if (indexTable != NULL) {
         delete indexTable;
     }
@@ -256,11 +303,11 @@ Prefiltering::~Prefiltering() {
 }
 
 void Prefiltering::setupSplit(DBReader<unsigned int>& tdbr, const int alphabetSize, const unsigned int querySeqTyp, const int threads,
-                              const bool templateDBIsIndex, const size_t memoryLimit, const size_t qDbSize,
+                              const bool templateDBIsIndex, const bool compressedIndex, const size_t memoryLimit, const size_t qDbSize,
                               size_t &maxResListLen, int &kmerSize, int &split, int &splitMode) {
     size_t memoryNeeded = estimateMemoryConsumption(1, tdbr.getSize(), tdbr.getAminoAcidDBSize(), maxResListLen, alphabetSize,
                                                     kmerSize == 0 ? // if auto detect kmerSize
-                                                    IndexTable::computeKmerSize(tdbr.getAminoAcidDBSize()) : kmerSize, querySeqTyp, threads);
+                                                    IndexTable::computeKmerSize(tdbr.getAminoAcidDBSize()) : kmerSize, querySeqTyp, threads, compressedIndex);
 
     int optimalSplitMode = Parameters::TARGET_DB_SPLIT;
     if (memoryNeeded > 0.9 * memoryLimit) {
@@ -293,16 +340,11 @@ void Prefiltering::setupSplit(DBReader<unsigned int>& tdbr, const int alphabetSi
     if (memoryNeeded > 0.9 * memoryLimit) {
         // memory is not enough to compute everything at once
         //TODO add PROFILE_STATE (just 6-mers)
-        std::pair<int, int> splitSettings = Prefiltering::optimizeSplit(memoryLimit, &tdbr, alphabetSize, kmerSize, querySeqTyp, threads);
+        std::pair<int, int> splitSettings = Prefiltering::optimizeSplit(memoryLimit, &tdbr, alphabetSize, kmerSize, querySeqTyp, threads, compressedIndex);
         if (splitSettings.second == -1) {
             Debug(Debug::ERROR) << "Cannot fit databases into " << ByteParser::format(memoryLimit) << ". Please use a computer with more main memory.\n";
             EXIT(EXIT_FAILURE);
         }
-        if (kmerSize == 0) {
-            // set k-mer based on aa size in database
-            // if we have less than 10Mio * 335 amino acids use 6mers
-            kmerSize = splitSettings.first;
-        }
         minimalNumSplits = splitSettings.second;
     }
 
@@ -334,8 +376,7 @@ void Prefiltering::setupSplit(DBReader<unsigned int>& tdbr, const int alphabetSi
     }
 
     if (kmerSize == 0) {
-        size_t aaSize = tdbr.getAminoAcidDBSize() / std::max(split, 1);
-        kmerSize = IndexTable::computeKmerSize(aaSize);
+        kmerSize = getSplitKmerSize(tdbr, alphabetSize, querySeqTyp, threads, compressedIndex, memoryLimit, maxResListLen, kmerSize, split);
     }
 
     // in TARGET_DB_SPLIT we have to reduce the number of prefilter hits can produce,
@@ -350,7 +391,7 @@ void Prefiltering::setupSplit(DBReader<unsigned int>& tdbr, const int alphabetSi
     }
 
     size_t memoryNeededPerSplit = estimateMemoryConsumption((splitMode == Parameters::TARGET_DB_SPLIT) ? split : 1, tdbr.getSize(),
-                                                            tdbr.getAminoAcidDBSize(), maxResListLen, alphabetSize, kmerSize, querySeqTyp, threads);
+                                                            tdbr.getAminoAcidDBSize(), maxResListLen, alphabetSize, kmerSize, querySeqTyp, threads, compressedIndex);
     Debug(Debug::INFO) << "Estimated memory consumption: " << ByteParser::format(memoryNeededPerSplit) << "\n";
     if (memoryNeededPerSplit > 0.9 * memoryLimit) {
         Debug(Debug::WARNING) << "Process needs more than " << ByteParser::format(memoryLimit) << " main memory.\n" <<
@@ -521,7 +562,7 @@ void Prefiltering::getIndexTable(int split, size_t dbFrom, size_t dbSize) {
         SequenceLookup **unmaskedLookup = maskMode == 0 ? &sequenceLookup : NULL;
 
         Debug(Debug::INFO) << "Index table k-mer threshold: " << localKmerThr << " at k-mer size " << kmerSize << " \n";
-        IndexBuilder::fillDatabase(indexTable, maskedLookup, unmaskedLookup, *kmerSubMat,  &tseq, tdbr, dbFrom, dbFrom + dbSize, localKmerThr, maskMode, maskLowerCaseMode);
+        IndexBuilder::fillDatabase(indexTable, maskedLookup, unmaskedLookup, *kmerSubMat,  &tseq, tdbr, dbFrom, dbFrom + dbSize, localKmerThr, maskMode, maskLowerCaseMode, compressKmerIndex);
 
         // sequenceLookup has to be temporarily present to speed up masking
         // afterwards its not needed anymore without diagonal scoring
@@ -536,6 +577,47 @@ void Prefiltering::getIndexTable(int split, size_t dbFrom, size_t dbSize) {
     }
 }
 
+void Prefiltering::replicateIndexTable(const NumaTopology &topology, IndexTable *indexTable, SequenceLookup *sequenceLookup,
+                                       std::vector<IndexTable *> &nodeIndexTables, std::vector<SequenceLookup *> &nodeSequenceLookups) {
+    Timer timer;
+    const size_t nodes = topology.getNodeCount();
+    nodeIndexTables.resize(nodes, NULL);
+    nodeSequenceLookups.resize(nodes, NULL);
+    // the original serves node 0, only the other nodes get a copy
+    nodeIndexTables[0] = indexTable;
+    nodeSequenceLookups[0] = sequenceLookup;
+#pragma omp parallel for num_threads(nodes) schedule(static, 1)
+    for (size_t node = 1; node < nodes; node++) {
+        // pages are placed on the node of the thread that writes them first
+        topology.bindThreadToNode(node);
+        IndexTable *nodeIndexTable = new IndexTable(indexTable->getAlphabetSize(), indexTable->getKmerSize(), false);
+        if (indexTable->isCompressed()) {
+            nodeIndexTable->initCompressedTableByExternalDataCopy(indexTable->getSize(), indexTable->getTableEntriesNum(),
+                                                                  indexTable->getCompressedEntries(), indexTable->getOffsets());
+        } else {
+            nodeIndexTable->initTableByExternalDataCopy(indexTable->getSize(), indexTable->getTableEntriesNum(),
+                                                        indexTable->getEntries(), indexTable->getOffsets());
+        }
+        nodeIndexTables[node] = nodeIndexTable;
+        if (sequenceLookup != NULL) {
+            SequenceLookup *nodeSequenceLookup = new SequenceLookup(sequenceLookup->getSequenceCount(), sequenceLookup->getDataSize());
+            nodeSequenceLookup->initLookupByExternalDataCopy(const_cast<char *>(sequenceLookup->getData()), sequenceLookup->getOffsets());
+            nodeSequenceLookups[node] = nodeSequenceLookup;
+        }
+        topology.unbindThread();
+    }
+    Debug(Debug::INFO) << "Time for NUMA index replicas: " << timer.lap() << "\n";
+}
+
+void Prefiltering::deleteIndexReplicas(std::vector<IndexTable *> &nodeIndexTables, std::vector<SequenceLookup *> &nodeSequenceLookups) {
+    for (size_t node = 1; node < nodeIndexTables.size(); node++) {
+        delete nodeIndexTables[node];
+        delete nodeSequenceLookups[node];
+    }
+    nodeIndexTables.clear();
+    nodeSequenceLookups.clear();
+}
+
 bool Prefiltering::isSameQTDB() {
     //  check if when qdb and tdb have the same name an index extension exists
     std::string check(targetDB);
@@ -721,6 +803,7 @@ bool Prefiltering::runSplit(const std::string &resultDB, const std::string &resu
             return false;
         }
 
+        deleteIndexReplicas(nodeIndexTables, nodeSequenceLookups);
         if (indexTable != NULL) {
             delete indexTable;
             indexTable = NULL;
@@ -771,18 +854,38 @@ bool Prefiltering::runSplit(const std::string &resultDB, const std::string &resu
     Debug(Debug::INFO) << "Starting prefiltering scores calculation (step " << (split + 1) << " of " << splits << ")\n";
     Debug(Debug::INFO) << "Query db start " << (queryFrom + 1) << " to " << queryFrom + querySize << "\n";
     Debug(Debug::INFO) << "Target db start " << (dbFrom + 1) << " to " << dbFrom + dbSize << "\n";
+    // short queries are matched in batches to share the fixed costs of a k-mer matching pass
+    // the fragments of a contig follow each other in a six-frame fragment database, so a batch covers most of a contig
+    const size_t maxBatchSize = QueryMatcher::getBatchSize(dbSize);
+    const bool batchSplitQueries = batchShortQueries && maxBatchSize > 1;
+    const size_t queriesPerStep = batchSplitQueries ? maxBatchSize : 1;
+    const size_t stepsPerChunk = batchSplitQueries ? 1 : 2;
+
     Debug::Progress progress(querySize);
 
+    if (numaReplicate && nodeIndexTables.empty()) {
+        replicateIndexTable(numaTopology, indexTable, sequenceLookup, nodeIndexTables, nodeSequenceLookups);
+    }
+
 #pragma omp parallel num_threads(localThreads)
     {
         unsigned int thread_idx = 0;
 #ifdef OPENMP
         thread_idx = static_cast<unsigned int>(omp_get_thread_num());
 #endif
+        // each thread matches against the copy of the index on its own node
+        IndexTable *threadIndexTable = indexTable;
+        SequenceLookup *threadSequenceLookup = sequenceLookup;
+        if (nodeIndexTables.empty() == false) {
+            const size_t node = numaTopology.getNodeOfThread(thread_idx, localThreads);
+            numaTopology.bindThreadToNode(node);
+            threadIndexTable = nodeIndexTables[node];
+            threadSequenceLookup = nodeSequenceLookups[node];
+        }
         Sequence seq(qdbr->getMaxSeqLen(), querySeqType, kmerSubMat, kmerSize, spacedKmer, aaBiasCorrection, true, spacedKmerPattern);
-        QueryMatcher matcher(indexTable, sequenceLookup, kmerSubMat,  ungappedSubMat,
+        QueryMatcher matcher(threadIndexTable, threadSequenceLookup, kmerSubMat,  ungappedSubMat,
                              kmerThr, kmerSize, dbSize, std::max(tdbr->getMaxSeqLen(),qdbr->getMaxSeqLen()), maxResListLen, aaBiasCorrection,
-                             diagonalScoring, minDiagScoreThr, takeOnlyBestKmer, targetSeqType==Parameters::DBTYPE_NUCLEOTIDES);
+                             diagonalScoring, minDiagScoreThr, takeOnlyBestKmer, targetSeqType==Parameters::DBTYPE_NUCLEOTIDES, batchSplitQueries);
 
         if (seq.profile_matrix != NULL) {
             matcher.setProfileMatrix(seq.profile_matrix);
@@ -792,79 +895,139 @@ bool Prefiltering::runSplit(const std::string &resultDB, const std::string &resu
             matcher.setSubstitutionMatrix(NULL, NULL);
         }
 
+        Sequence *batchSeqs[QueryMatcher::MAX_BATCH_SIZE];
+        size_t batchIds[QueryMatcher::MAX_BATCH_SIZE];
+        if (matcher.canBatchQueries()) {
+            for (size_t i = 0; i < maxBatchSize; i++) {
+                batchSeqs[i] = new Sequence(QueryMatcher::BATCH_MAX_QUERY_LEN, querySeqType, kmerSubMat, kmerSize, spacedKmer, aaBiasCorrection, true, spacedKmerPattern);
+            }
+        }
+
         char buffer[128];
         std::string result;
         result.reserve(1000000);
 
-#pragma omp for schedule(dynamic, 2) reduction (+: kmersPerPos, resSize, dbMatches, doubleMatches, querySeqLenSum, diagonalOverflow, trancatedCounter)
-        for (size_t id = queryFrom; id < queryFrom + querySize; id++) {
-            progress.updateProgress();
-            // get query sequence
-            char *seqData = qdbr->getData(id, thread_idx);
-            unsigned int qKey = qdbr->getDbKey(id);
-            seq.mapSequence(id, qKey, seqData, qdbr->getSeqLen(id));
-            size_t targetSeqId = UINT_MAX;
-            if (sameQTDB || includeIdentical) {
-                targetSeqId = tdbr->getId(seq.getDbKey());
-                // only the corresponding split should include the id (hack for the hack)
-                if (targetSeqId >= dbFrom && targetSeqId < (dbFrom + dbSize) && targetSeqId != UINT_MAX) {
-                    targetSeqId = targetSeqId - dbFrom;
-                    if(targetSeqId > tdbr->getSize()){
-                        Debug(Debug::ERROR) << "targetSeqId: " << targetSeqId << " > target database size: "  << tdbr->getSize() <<  "\n";
-                        EXIT(EXIT_FAILURE);
+#pragma omp for schedule(dynamic, stepsPerChunk) reduction (+: kmersPerPos, resSize, dbMatches, doubleMatches, querySeqLenSum, diagonalOverflow, trancatedCounter)
+        for (size_t stepStart = queryFrom; stepStart < queryFrom + querySize; stepStart += queriesPerStep) {
+            const size_t stepEnd = std::min(stepStart + queriesPerStep, queryFrom + querySize);
+
+            auto getIdentityId = [&](unsigned int qKey) {
+                size_t targetSeqId = UINT_MAX;
+                if (sameQTDB || includeIdentical) {
+                    targetSeqId = tdbr->getId(qKey);
+                    // only the corresponding split should include the id (hack for the hack)
+                    if (targetSeqId >= dbFrom && targetSeqId < (dbFrom + dbSize) && targetSeqId != UINT_MAX) {
+                        targetSeqId = targetSeqId - dbFrom;
+                        if(targetSeqId > tdbr->getSize()){
+                            Debug(Debug::ERROR) << "targetSeqId: " << targetSeqId << " > target database size: "  << tdbr->getSize() <<  "\n";
+                            EXIT(EXIT_FAILURE);
+                        }
+                    }else{
+                        targetSeqId = UINT_MAX;
                     }
-                }else{
-                    targetSeqId = UINT_MAX;
-                }
-            }
-            // calculate prefiltering results
-            std::pair<hit_t *, size_t> prefResults = matcher.matchQuery(&seq, targetSeqId, targetSeqType==Parameters::DBTYPE_NUCLEOTIDES);
-            size_t resultSize = prefResults.second;
-            const float queryLength = static_cast<float>(qdbr->getSeqLen(id));
-            for (size_t i = 0; i < resultSize; i++) {
-                hit_t *res = prefResults.first + i;
-                // correct the 0 indexed sequence id again to its real identifier
-                size_t targetSeqId1 = res->seqId + dbFrom;
-                // replace id with key
-                res->seqId = tdbr->getDbKey(targetSeqId1);
-                if (UNLIKELY(targetSeqId1 >= tdbr->getSize())) {
-                    Debug(Debug::WARNING) << "Wrong prefiltering result for query: " << qdbr->getDbKey(id) << " -> " << targetSeqId1 << "\t" << res->prefScore << "\n";
                 }
+                return targetSeqId;
+            };
+
+            auto writeResult = [&](size_t id, Sequence *querySeq, std::pair<hit_t *, size_t> prefResults) {
+                progress.updateProgress();
+                size_t resultSize = prefResults.second;
+                const float queryLength = static_cast<float>(qdbr->getSeqLen(id));
+                for (size_t i = 0; i < resultSize; i++) {
+                    hit_t *res = prefResults.first + i;
+                    // correct the 0 indexed sequence id again to its real identifier
+                    size_t targetSeqId1 = res->seqId + dbFrom;
+                    // replace id with key
+                    res->seqId = tdbr->getDbKey(targetSeqId1);
+                    if (UNLIKELY(targetSeqId1 >= tdbr->getSize())) {
+                        Debug(Debug::WARNING) << "Wrong prefiltering result for query: " << qdbr->getDbKey(id) << " -> " << targetSeqId1 << "\t" << res->prefScore << "\n";
+                    }
 
-                // TODO: check if this should happen when diagonalScoring == false
-                if (covThr > 0.0 && (covMode == Parameters::COV_MODE_BIDIRECTIONAL
-                                               || covMode == Parameters::COV_MODE_QUERY
-                                               || covMode == Parameters::COV_MODE_LENGTH_SHORTER )) {
-                    const float targetLength = static_cast<float>(tdbr->getSeqLen(targetSeqId1));
-                    if (Util::canBeCovered(covThr, covMode, queryLength, targetLength) == false) {
-                        continue;
+                    // TODO: check if this should happen when diagonalScoring == false
+                    if (covThr > 0.0 && (covMode == Parameters::COV_MODE_BIDIRECTIONAL
+                                                   || covMode == Parameters::COV_MODE_QUERY
+                                                   || covMode == Parameters::COV_MODE_LENGTH_SHORTER )) {
+                        const float targetLength = static_cast<float>(tdbr->getSeqLen(targetSeqId1));
+                        if (Util::canBeCovered(covThr, covMode, queryLength, targetLength) == false) {
+                            continue;
+                        }
                     }
+
+                    // write prefiltering results to a string
+                    int len = QueryMatcher::prefilterHitToBuffer(buffer, *res);
+                    result.append(buffer, len);
                 }
+                tmpDbw.writeData(result.c_str(), result.length(), querySeq->getDbKey(), thread_idx);
+                result.clear();
 
-                // write prefiltering results to a string
-                int len = QueryMatcher::prefilterHitToBuffer(buffer, *res);
-                result.append(buffer, len);
-            }
-            tmpDbw.writeData(result.c_str(), result.length(), qKey, thread_idx);
-            result.clear();
+                // update statistics counters
+                if (resultSize != 0) {
+                    notEmpty[id - queryFrom] = 1;
+                }
 
-            // update statistics counters
-            if (resultSize != 0) {
-                notEmpty[id - queryFrom] = 1;
+                if (Debug::debugLevel >= Debug::INFO) {
+                    kmersPerPos += matcher.getStatistics()->kmersPerPos;
+                    dbMatches += matcher.getStatistics()->dbMatches;
+                    doubleMatches += matcher.getStatistics()->doubleMatches;
+                    querySeqLenSum += querySeq->L;
+                    diagonalOverflow += matcher.getStatistics()->diagonalOverflow;
+                    trancatedCounter += matcher.getStatistics()->truncated;
+                    resSize += resultSize;
+                    realResSize += std::min(resultSize, maxResListLen);
+                    reslens[thread_idx]->emplace_back(resultSize);
+                }
+            };
+
+            // long queries are matched one by one, the short ones are collected for the batch
+            size_t batchSize = 0;
+            for (size_t id = stepStart; id < stepEnd; id++) {
+                // get query sequence
+                char *seqData = qdbr->getData(id, thread_idx);
+                unsigned int qKey = qdbr->getDbKey(id);
+                if (matcher.canBatchQueries() && qdbr->getSeqLen(id) <= QueryMatcher::BATCH_MAX_QUERY_LEN) {
+                    batchSeqs[batchSize]->mapSequence(id, qKey, seqData, qdbr->getSeqLen(id));
+                    batchIds[batchSize] = id;
+                    batchSize++;
+                    continue;
+                }
+                seq.mapSequence(id, qKey, seqData, qdbr->getSeqLen(id));
+                // calculate prefiltering results
+                writeResult(id, &seq, matcher.matchQuery(&seq, getIdentityId(qKey), targetSeqType==Parameters::DBTYPE_NUCLEOTIDES));
             }
 
-            if (Debug::debugLevel >= Debug::INFO) {
-                kmersPerPos += matcher.getStatistics()->kmersPerPos;
-                dbMatches += matcher.getStatistics()->dbMatches;
-                doubleMatches += matcher.getStatistics()->doubleMatches;
-                querySeqLenSum += seq.L;
-                diagonalOverflow += matcher.getStatistics()->diagonalOverflow;
-                trancatedCounter += matcher.getStatistics()->truncated;
-                resSize += resultSize;
-                realResSize += std::min(resultSize, maxResListLen);
-                reslens[thread_idx]->emplace_back(resultSize);
+            // a batch ends early if its k-mer hits do not fit, the remaining queries start the next batch
+            // if not even the first query fits, the rest of the batch is matched one by one instead of retrying the batch
+            size_t batchStart = 0;
+            while (batchStart < batchSize) {
+                size_t matched = 0;
+                if (batchSize - batchStart > 1) {
+                    matched = matcher.matchQueryBatch(batchSeqs + batchStart, batchSize - batchStart);
+                }
+                if (matched == 0) {
+                    for (; batchStart < batchSize; batchStart++) {
+                        Sequence *querySeq = batchSeqs[batchStart];
+                        writeResult(batchIds[batchStart], querySeq,
+                                    matcher.matchQuery(querySeq, getIdentityId(querySeq->getDbKey()), targetSeqType==Parameters::DBTYPE_NUCLEOTIDES));
+                    }
+                    break;
+                }
+                for (size_t slot = 0; slot < matched; slot++) {
+                    Sequence *querySeq = batchSeqs[batchStart + slot];
+                    writeResult(batchIds[batchStart + slot], querySeq,
+                                matcher.getBatchResult(slot, getIdentityId(querySeq->getDbKey()), targetSeqType==Parameters::DBTYPE_NUCLEOTIDES));
+                }
+                batchStart += matched;
             }
         } // step end
+
+        if (matcher.canBatchQueries()) {
+            for (size_t i = 0; i < maxBatchSize; i++) {
+                delete batchSeqs[i];
+            }
+        }
+        if (nodeIndexTables.empty() == false) {
+            numaTopology.unbindThread();
+        }
     }
 
     if (Debug::debugLevel >= Debug::INFO) {
@@ -900,6 +1063,7 @@ bool Prefiltering::runSplit(const std::string &resultDB, const std::string &resu
     // sorts this datafile according to the index file
     if (splitMode == Parameters::TARGET_DB_SPLIT && splits > 1) {
         // free memory early since the merge might need quite a bit of memory
+        deleteIndexReplicas(nodeIndexTables, nodeSequenceLookups);
         if (indexTable != NULL) {
             delete indexTable;
             indexTable = NULL;
@@ -1023,12 +1187,18 @@ int Prefiltering::getKmerThreshold(const float sensitivity, const bool isProfile
 size_t Prefiltering::estimateMemoryConsumption(int split, size_t dbSize, size_t resSize,
                                                size_t maxResListLen,
                                                int alphabetSize, int kmerSize, unsigned int querySeqType,
-                                               int threads) {
+                                               int threads, bool compressedIndex) {
     // for each residue in the database we need 7 byte
     size_t dbSizeSplit = (dbSize) / split;
     size_t residueSize = (resSize / split * 7);
     // 21^7 * pointer size is needed for the index
     size_t indexTableSize = static_cast<size_t>(pow(alphabetSize, kmerSize)) * sizeof(size_t);
+    if (compressedIndex) {
+        // compressed entries and the sequence lookup, plus the entries of the k-mer range that is filled uncompressed
+        const size_t resSizeSplit = resSize / split;
+        residueSize = static_cast<size_t>(resSizeSplit * (IndexTable::estimateCompressedEntrySize(dbSizeSplit, resSizeSplit, indexTableSize / sizeof(size_t)) + 1))
+                      + IndexTable::getCompressionRangeSize(resSizeSplit) * sizeof(IndexEntryLocal);
+    }
     // memory needed for the threads
     // This memory is an approx. for Countint32Array and QueryTemplateLocalFast
     size_t threadSize = threads * (
@@ -1052,6 +1222,137 @@ size_t Prefiltering::estimateMemoryConsumption(int split, size_t dbSize, size_t
     return residueSize + indexTableSize + threadSize + background + extendedMatrix + dbReaderSize;
 }
 
+size_t Prefiltering::estimateBatchMemoryConsumption(int split, size_t dbSize, int threads) {
+    size_t dbSizeSplit = (dbSize) / split;
+    return threads * (
+            (dbSizeSplit * sizeof(CounterResult)) // batchDiagonals in QueryMatcher
+            + (dbSizeSplit * 2 * sizeof(CounterResult) * 2) // bins of the batch queries
+    );
+}
+
+bool Prefiltering::planThroughputSplit(DBReader<unsigned int>& tdbr, const int alphabetSize, const unsigned int querySeqType,
+                                       const int threads, const bool compressedIndex, const size_t memoryLimit,
+                                       const size_t qDbSize, const std::vector<size_t> &queryLengthCounts,
+                                       const size_t maxResListLen, const int kmerSize, int &split, int &splitMode) {
+    // costs in ns of one thread, taken from the timings prefilter logs for a run at -s 1 with 60k six-frame fragments
+    // (2.5M residues) against 300k targets (90M residues), so they weigh the terms against each other rather than predict
+    // building the index of a split: masking, counting and filling per target residue, 19 s for the whole index
+    const double buildResidueCost = 200.0;
+    // allocating, clearing and summing the k-mer offset table of a split per table entry,
+    // 0.33 s at k=6 and 16 ms at k=5 for a 200-sequence target database
+    const double tableEntryCost = 5.0;
+    // matching all queries against the index of a split: similar k-mer generation and lookups per query k-mer,
+    // each extra split added 1.75 s for the 2.2M k-mers of the fragments at k=6
+    // counting the diagonals of the hits is left out, its total does not change with the splits
+    // matching short queries in batches takes about as long, so batching only depends on the memory left by the plan
+    const double queryKmerCost = 800.0;
+#ifdef HAVE_MPI
+    const size_t ranks = static_cast<size_t>(std::max(MMseqsMPI::numProc, 1));
+#else
+    const size_t ranks = 1;
+#endif
+    const size_t targetResidues = tdbr.getAminoAcidDBSize();
+    // a query has a k-mer at each of its positions but the last k-1, so short queries lose more to a larger k
+    std::vector<double> queryKmers;
+    const auto getQueryKmers = [&](int k) {
+        if (static_cast<size_t>(k) >= queryKmers.size()) {
+            queryKmers.resize(k + 1, -1.0);
+        }
+        if (queryKmers[k] < 0.0) {
+            double kmers = 0.0;
+            for (size_t len = k; len < queryLengthCounts.size(); len++) {
+                kmers += static_cast<double>(queryLengthCounts[len]) * (len - k + 1);
+            }
+            queryKmers[k] = kmers;
+        }
+        return queryKmers[k];
+    };
+
+    struct SplitPlan {
+        int splitMode;
+        int splits;
+        size_t memory;
+        double cost;
+    };
+    std::vector<SplitPlan> plans;
+    // a query split builds the index of the whole target database on every rank and divides the queries among the ranks
+    {
+        const int k = getSplitKmerSize(tdbr, alphabetSize, querySeqType, threads, compressedIndex, memoryLimit, maxResListLen, kmerSize, 1);
+        const size_t memory = estimateMemoryConsumption(1, tdbr.getSize(), targetResidues, maxResListLen, alphabetSize, k, querySeqType, threads, compressedIndex);
+        if (k > 0 && memory < 0.9 * memoryLimit) {
+            const double cost = buildResidueCost * targetResidues + tableEntryCost * pow(alphabetSize, k)
+                                + queryKmerCost * getQueryKmers(k) / std::min(ranks, std::max(qDbSize, static_cast<size_t>(1)));
+            SplitPlan plan = { Parameters::QUERY_DB_SPLIT, 1, memory, cost };
+            plans.push_back(plan);
+        }
+    }
+    // a target split builds a part of the index per split and matches all queries against each part,
+    // the ranks work on their splits in parallel
+    // more splits need less diagonal memory per thread but reread the queries and rebuild a k-mer table each
+    {
+        SplitPlan best = { Parameters::TARGET_DB_SPLIT, 0, 0, 0.0 };
+        const int maxSplits = static_cast<int>(std::min(tdbr.getSize(), static_cast<size_t>(1000)));
+        for (int s = 1; s <= maxSplits; s++) {
+            const int k = getSplitKmerSize(tdbr, alphabetSize, querySeqType, threads, compressedIndex, memoryLimit, maxResListLen, kmerSize, s);
+            if (k <= 0) {
+                break;
+            }
+            const size_t memory = estimateMemoryConsumption(s, tdbr.getSize(), targetResidues, maxResListLen, alphabetSize, k, querySeqType, threads, compressedIndex);
+            if (memory >= 0.9 * memoryLimit) {
+                continue;
+            }
+            const double rounds = (s + ranks - 1) / ranks;
+            const double cost = rounds * (buildResidueCost * targetResidues / s + tableEntryCost * pow(alphabetSize, k) + queryKmerCost * getQueryKmers(k));
+            if (best.splits == 0 || cost < best.cost) {
+                best.splits = s;
+                best.memory = memory;
+                best.cost = cost;
+            }
+        }
+        if (best.splits > 0) {
+            plans.push_back(best);
+        }
+    }
+    if (plans.empty()) {
+        Debug(Debug::INFO) << "No split plan fits into " << ByteParser::format(memoryLimit) << "\n";
+        return false;
+    }
+
+    // on equal costs the query split is kept, as in the automatic split mode
+    size_t best = 0;
+    for (size_t i = 0; i < plans.size(); i++) {
+        Debug(Debug::INFO) << "Split plan: " << Parameters::getSplitModeName(plans[i].splitMode) << " split, " << plans[i].splits << " split(s), "
+                           << "memory " << ByteParser::format(plans[i].memory) << ", estimated time " << static_cast<size_t>(plans[i].cost / 1e9 / std::max(threads, 1) + 0.5) << "s\n";
+        if (plans[i].cost < plans[best].cost) {
+            best = i;
+        }
+    }
+    const SplitPlan &plan = plans[best];
+    Debug(Debug::INFO) << "Throughput split mode. Using the " << Parameters::getSplitModeName(plan.splitMode) << " split plan with "
+                       << plan.splits << " split(s)\n";
+    splitMode = plan.splitMode;
+    if (split == 0 && plan.splitMode == Parameters::TARGET_DB_SPLIT) {
+        split = plan.splits;
+    }
+    return true;
+}
+
+int Prefiltering::getSplitKmerSize(DBReader<unsigned int>& tdbr, const int alphabetSize, const unsigned int querySeqType,
+                                   const int threads, const bool compressedIndex, const size_t memoryLimit,
+                                   const size_t maxResListLen, const int kmerSize, const int split) {
+    if (kmerSize != 0) {
+        return kmerSize;
+    }
+    size_t memoryNeeded = estimateMemoryConsumption(1, tdbr.getSize(), tdbr.getAminoAcidDBSize(), maxResListLen, alphabetSize,
+                                                    IndexTable::computeKmerSize(tdbr.getAminoAcidDBSize()), querySeqType, threads, compressedIndex);
+    if (memoryNeeded > 0.9 * memoryLimit) {
+        // set k-mer based on aa size in database
+        // if we have less than 10Mio * 335 amino acids use 6mers
+        return optimizeSplit(memoryLimit, &tdbr, alphabetSize, kmerSize, querySeqType, threads, compressedIndex).first;
+    }
+    return IndexTable::computeKmerSize(tdbr.getAminoAcidDBSize() / std::max(split, 1));
+}
+
 size_t Prefiltering::estimateHDDMemoryConsumption(size_t dbSize, size_t maxResListLen) {
     // 21 bytes is roughly the size of an entry
     // 2x because the merge doubles the hdd demand
@@ -1059,7 +1360,8 @@ size_t Prefiltering::estimateHDDMemoryConsumption(size_t dbSize, size_t maxResLi
 }
 
 std::pair<int, int> Prefiltering::optimizeSplit(size_t totalMemoryInByte, DBReader<unsigned int> *tdbr,
-                                                int alphabetSize, int externalKmerSize, unsigned int querySeqType, unsigned int threads) {
+                                                int alphabetSize, int externalKmerSize, unsigned int querySeqType, unsigned int threads,
+                                                bool compressedIndex) {
 
     int startKmerSize = (externalKmerSize == 0) ? 6 : externalKmerSize;
     int endKmerSize   = (externalKmerSize == 0) ? 7 : externalKmerSize;
@@ -1083,7 +1385,7 @@ std::pair<int, int> Prefiltering::optimizeSplit(size_t totalMemoryInByte, DBRead
                 size_t neededSize = estimateMemoryConsumption(optSplit, tdbr->getSize(),
                                                               tdbr->getAminoAcidDBSize(),
                                                               0, alphabetSize, optKmerSize, querySeqType,
-                                                              threads);
+                                                              threads, compressedIndex);
                 if (neededSize < 0.9 * totalMemoryInByte) {
                     return std::make_pair(optKmerSize, optSplit);
                 }
@@ -8,6 +8,7 @@
 #include "ScoreMatrix.h"
 #include "PrefilteringIndexReader.h"
 #include "QueryMatcher.h"
+#include "NumaTopology.h"
 
 #include <string>
 #include <list>
@@ -41,7 +42,7 @@ public:
     static BaseMatrix *getSubstitutionMatrix(const MultiParam<char*> &scoringMatrixFile, MultiParam<int> alphabetSize, float bitFactor, bool profileState, bool isNucl);
 
     static void setupSplit(DBReader<unsigned int>& dbr, const int alphabetSize, const unsigned int querySeqType, const int threads,
-                           const bool templateDBIsIndex, const size_t memoryLimit, const size_t qDbSize,
+                           const bool templateDBIsIndex, const bool compressedIndex, const size_t memoryLimit, const size_t qDbSize,
                            size_t& maxResListLen, int& kmerSize, int& split, int& splitMode);
 
     static int getKmerThreshold(const float sensitivity, const bool isProfile, const int kmerScore, const int kmerSize);
@@ -49,6 +50,12 @@ public:
     static void mergeTargetSplits(const std::string &outDB, const std::string &outDBIndex,
                                   const std::vector<std::pair<std::string, std::string>> &fileNames, unsigned int threads);
 
+    // copies the index table and sequence lookup to each NUMA node of the topology but node 0,
+    // which uses the originals, they stay owned by the caller and are not deleted by deleteIndexReplicas
+    static void replicateIndexTable(const NumaTopology &topology, IndexTable *indexTable, SequenceLookup *sequenceLookup,
+                                    std::vector<IndexTable *> &nodeIndexTables, std::vector<SequenceLookup *> &nodeSequenceLookups);
+    static void deleteIndexReplicas(std::vector<IndexTable *> &nodeIndexTables, std::vector<SequenceLookup *> &nodeSequenceLookups);
+
 private:
     const std::string queryDB;
     const std::string queryDBIndex;
@@ -97,18 +104,44 @@ private:
     int preloadMode;
     const unsigned int threads;
     int compressed;
+    // match short queries in batches
+    bool batchShortQueries;
+    // copies of the index table and sequence lookup on each NUMA node
+    bool numaReplicate;
+    NumaTopology numaTopology;
+    std::vector<IndexTable *> nodeIndexTables;
+    std::vector<SequenceLookup *> nodeSequenceLookups;
+    // keep the k-mer lists of the index table compressed
+    bool compressKmerIndex;
 
     bool runSplit(const std::string &resultDB, const std::string &resultDBIndex, size_t split, bool merge);
 
+    // k-mer size setupSplit uses with split target splits: kmerSize if set, the one of optimizeSplit
+    // if the whole index does not fit into memoryLimit or else the one for the residues of a split, -1 if nothing fits
+    static int getSplitKmerSize(DBReader<unsigned int>& tdbr, const int alphabetSize, const unsigned int querySeqType,
+                                const int threads, const bool compressedIndex, const size_t memoryLimit,
+                                const size_t maxResListLen, const int kmerSize, const int split);
+
     // compute kmer size and split size for index table
     static std::pair<int, int> optimizeSplit(size_t totalMemoryInByte, DBReader<unsigned int> *tdbr, int alphabetSize, int kmerSize,
-                                             unsigned int querySeqType, unsigned int threads);
+                                             unsigned int querySeqType, unsigned int threads, bool compressedIndex);
 
     // estimates memory consumption while runtime
     static size_t estimateMemoryConsumption(int split, size_t dbSize, size_t resSize,
                                             size_t maxHitsPerQuery,
                                             int alphabetSize, int kmerSize, unsigned int querySeqType,
-                                            int threads);
+                                            int threads, bool compressedIndex);
+
+    // estimates the additional memory of matching short queries in batches
+    static size_t estimateBatchMemoryConsumption(int split, size_t dbSize, int threads);
+
+    // chooses the split mode and number of target splits with the lowest estimated time for building the index
+    // and matching the queries that fits into memoryLimit, returns false if no plan fits
+    // queryLengthCounts[l] is the number of queries with l residues
+    static bool planThroughputSplit(DBReader<unsigned int>& tdbr, const int alphabetSize, const unsigned int querySeqType,
+                                    const int threads, const bool compressedIndex, const size_t memoryLimit,
+                                    const size_t qDbSize, const std::vector<size_t> &queryLengthCounts,
+                                    const size_t maxResListLen, const int kmerSize, int &split, int &splitMode);
 
     static size_t estimateHDDMemoryConsumption(size_t dbSize, size_t maxResListLen);
 
@@ -118,6 +151,7 @@ private:
     // needed for index lookup
     void getIndexTable(int split, size_t dbFrom, size_t dbSize);
 
+
     void printStatistics(const statistics_t &stats, std::list<int> **reslens,
                          unsigned int resLensSize, size_t empty, size_t maxResults);
 
@@ -3,10 +3,12 @@
 #include "Prefiltering.h"
 #include "ExtendedSubstitutionMatrix.h"
 #include "FileUtil.h"
+#include "HugePageAllocator.h"
 #include "IndexBuilder.h"
 #include "Parameters.h"
 
 const char*  PrefilteringIndexReader::CURRENT_VERSION = "16";
+const char*  PrefilteringIndexReader::COMPRESSED_VERSION = "17";
 unsigned int PrefilteringIndexReader::VERSION = 0;
 unsigned int PrefilteringIndexReader::META = 1;
 unsigned int PrefilteringIndexReader::SCOREMATRIXNAME = 2;
@@ -30,6 +32,7 @@ unsigned int PrefilteringIndexReader::HDR2INDEX = 20;
 unsigned int PrefilteringIndexReader::HDR2DATA = 21;
 unsigned int PrefilteringIndexReader::GENERATOR = 22;
 unsigned int PrefilteringIndexReader::SPACEDPATTERN = 23;
+unsigned int PrefilteringIndexReader::COMPRESSEDENTRIES = 24;
 
 extern const char* version;
 
@@ -38,7 +41,8 @@ bool PrefilteringIndexReader::checkIfIndexFile(DBReader<unsigned int>* reader) {
     if(version == NULL){
         return false;
     }
-    return (strncmp(version, CURRENT_VERSION, strlen(CURRENT_VERSION)) == 0 ) ? true : false;
+    return (strncmp(version, CURRENT_VERSION, strlen(CURRENT_VERSION)) == 0
+            || strncmp(version, COMPRESSED_VERSION, strlen(COMPRESSED_VERSION)) == 0) ? true : false;
 }
 
 std::string PrefilteringIndexReader::indexName(const std::string &outDB) {
@@ -53,7 +57,7 @@ void PrefilteringIndexReader::createIndexFile(const std::string &outDB,
                                               BaseMatrix *subMat, int maxSeqLen,
                                               bool hasSpacedKmer, const std::string &spacedKmerPattern,
                                               bool compBiasCorrection, int alphabetSize, int kmerSize,
-                                              int maskMode, int maskLowerCase, int kmerThr, int splits) {
+                                              int maskMode, int maskLowerCase, int kmerThr, int splits, bool compressEntries) {
 
     const int SPLIT_META = splits > 1 ? 0 : 0;
     const int SPLIT_SEQS = splits > 1 ? 1 : 0;
@@ -62,8 +66,10 @@ void PrefilteringIndexReader::createIndexFile(const std::string &outDB,
     DBWriter writer(outDB.c_str(), std::string(outDB).append(".index").c_str(), splits > 1 ? splits + 2 : 1, Parameters::WRITER_ASCII_MODE, Parameters::DBTYPE_INDEX_DB);
     writer.open();
 
+    // readers that do not know COMPRESSEDENTRIES have to reject indexes with a compressed table
+    const char *indexVersion = compressEntries ? COMPRESSED_VERSION : CURRENT_VERSION;
     Debug(Debug::INFO) << "Write VERSION (" << VERSION << ")\n";
-    writer.writeData((char *) CURRENT_VERSION, strlen(CURRENT_VERSION) * sizeof(char), VERSION, SPLIT_META);
+    writer.writeData((char *) indexVersion, strlen(indexVersion) * sizeof(char), VERSION, SPLIT_META);
     writer.alignToPageSize(SPLIT_META);
 
     Debug(Debug::INFO) << "Write META (" << META << ")\n";
@@ -207,7 +213,7 @@ void PrefilteringIndexReader::createIndexFile(const std::string &outDB,
         IndexBuilder::fillDatabase(&indexTable,
                                    (maskMode == 1 || maskLowerCase == 1) ? &sequenceLookup : NULL,
                                    (maskMode == 0 ) ? &sequenceLookup : NULL,
-                                   *subMat, &seq, dbr1, dbFrom, dbFrom + dbSize, kmerThr, maskMode, maskLowerCase);
+                                   *subMat, &seq, dbr1, dbFrom, dbFrom + dbSize, kmerThr, maskMode, maskLowerCase, compressEntries);
         indexTable.printStatistics(subMat->num2aa);
 
         if (sequenceLookup == NULL) {
@@ -217,11 +223,19 @@ void PrefilteringIndexReader::createIndexFile(const std::string &outDB,
 
         // save the entries
         unsigned int keyOffset = 1000 * s;
-        Debug(Debug::INFO) << "Write ENTRIES (" << (keyOffset + ENTRIES) << ")\n";
-        char *entries = (char *) indexTable.getEntries();
-        size_t entriesSize = indexTable.getTableEntriesNum() * indexTable.getSizeOfEntry();
-        writer.writeData(entries, entriesSize, (keyOffset + ENTRIES), SPLIT_INDX + s);
-        writer.alignToPageSize(SPLIT_INDX + s);
+        if (indexTable.isCompressed()) {
+            // the offsets of a compressed table are byte offsets into these entries
+            Debug(Debug::INFO) << "Write COMPRESSEDENTRIES (" << (keyOffset + COMPRESSEDENTRIES) << ")\n";
+            char *entries = (char *) indexTable.getCompressedEntries();
+            writer.writeData(entries, indexTable.getCompressedEntriesSize(), (keyOffset + COMPRESSEDENTRIES), SPLIT_INDX + s);
+            writer.alignToPageSize(SPLIT_INDX + s);
+        } else {
+            Debug(Debug::INFO) << "Write ENTRIES (" << (keyOffset + ENTRIES) << ")\n";
+            char *entries = (char *) indexTable.getEntries();
+            size_t entriesSize = indexTable.getTableEntriesNum() * indexTable.getSizeOfEntry();
+            writer.writeData(entries, entriesSize, (keyOffset + ENTRIES), SPLIT_INDX + s);
+            writer.alignToPageSize(SPLIT_INDX + s);
+        }
 
         // save the size
         Debug(Debug::INFO) << "Write ENTRIESOFFSETS (" << (keyOffset + ENTRIESOFFSETS) << ")\n";
@@ -376,7 +390,12 @@ IndexTable *PrefilteringIndexReader::getIndexTable(unsigned int split, DBReader<
     size_t sequenceCountId = dbr->getId(splitOffset +SEQCOUNT);
     size_t sequenceCount = *((size_t *)dbr->getDataUncompressed(sequenceCountId));
 
-    size_t entriesDataId = dbr->getId(splitOffset + ENTRIES);
+    // indexes with a compressed table store COMPRESSEDENTRIES instead of ENTRIES
+    size_t entriesDataId = dbr->getId(splitOffset + COMPRESSEDENTRIES);
+    const bool compressed = (entriesDataId != UINT_MAX);
+    if (compressed == false) {
+        entriesDataId = dbr->getId(splitOffset + ENTRIES);
+    }
     char *entriesData = dbr->getDataUncompressed(entriesDataId);
 
     size_t entriesOffsetsDataId = dbr->getId(splitOffset + ENTRIESOFFSETS);
@@ -391,7 +410,11 @@ IndexTable *PrefilteringIndexReader::getIndexTable(unsigned int split, DBReader<
 
     if (preloadMode == Parameters::PRELOAD_MODE_FREAD) {
         IndexTable* table = new IndexTable(adjustAlphabetSize, data.kmerSize, false);
-        table->initTableByExternalDataCopy(sequenceCount, entriesNum, (IndexEntryLocal*) entriesData, (size_t *)entriesOffsetsData);
+        if (compressed) {
+            table->initCompressedTableByExternalDataCopy(sequenceCount, entriesNum, (unsigned char*) entriesData, (size_t *)entriesOffsetsData);
+        } else {
+            table->initTableByExternalDataCopy(sequenceCount, entriesNum, (IndexEntryLocal*) entriesData, (size_t *)entriesOffsetsData);
+        }
         return table;
     }
 
@@ -403,7 +426,15 @@ IndexTable *PrefilteringIndexReader::getIndexTable(unsigned int split, DBReader<
     }
 
     IndexTable* table = new IndexTable(adjustAlphabetSize, data.kmerSize, true);
-    table->initTableByExternalData(sequenceCount, entriesNum, (IndexEntryLocal*) entriesData, (size_t *)entriesOffsetsData);
+    // the mapped index is looked up at random positions as well
+    HugePageAllocator::advise(entriesOffsetsData, (table->getTableSize() + 1) * sizeof(size_t));
+    if (compressed) {
+        HugePageAllocator::advise(entriesData, ((size_t *)entriesOffsetsData)[table->getTableSize()]);
+        table->initCompressedTableByExternalData(sequenceCount, entriesNum, (unsigned char*) entriesData, (size_t *)entriesOffsetsData);
+    } else {
+        HugePageAllocator::advise(entriesData, entriesNum * sizeof(IndexEntryLocal));
+        table->initTableByExternalData(sequenceCount, entriesNum, (IndexEntryLocal*) entriesData, (size_t *)entriesOffsetsData);
+    }
     return table;
 }
 
@@ -505,6 +536,16 @@ std::string PrefilteringIndexReader::getSpacedPattern(DBReader<unsigned int> *db
     return std::string(dbr->getDataUncompressed(id));
 }
 
+bool PrefilteringIndexReader::isIndexTableCompressed(DBReader<unsigned int> *dbr) {
+    PrefilteringIndexData data = getMetadata(dbr);
+    for (int split = 0; split < data.splits; split++) {
+        if (dbr->getId(split * 1000 + COMPRESSEDENTRIES) != UINT_MAX) {
+            return true;
+        }
+    }
+    return false;
+}
+
 ScoreMatrix PrefilteringIndexReader::get2MerScoreMatrix(DBReader<unsigned int> *dbr, int preloadMode) {
     size_t id = dbr->getId(SCOREMATRIX2MER);
     if (id == UINT_MAX) {
@@ -25,6 +25,8 @@ struct PrefilteringIndexData {
 class PrefilteringIndexReader {
 public:
     static const char*  CURRENT_VERSION;
+    // version of indexes that store a compressed table
+    static const char*  COMPRESSED_VERSION;
     static unsigned int VERSION;
     static unsigned int ENTRIES;
     static unsigned int ENTRIESOFFSETS;
@@ -49,6 +51,7 @@ public:
     static unsigned int HDR2DATA;
     static unsigned int GENERATOR;
     static unsigned int SPACEDPATTERN;
+    static unsigned int COMPRESSEDENTRIES;
 
     static bool checkIfIndexFile(DBReader<unsigned int> *reader);
     static std::string indexName(const std::string &outDB);
@@ -57,7 +60,7 @@ public:
                                 DBReader<unsigned int> *dbr1, DBReader<unsigned int> *dbr2,
                                 DBReader<unsigned int> *hdbr1, DBReader<unsigned int> *hdbr2,
                                 BaseMatrix *seedSubMat, int maxSeqLen, bool spacedKmer, const std::string &spacedKmerPattern,
-                                bool compBiasCorrection, int alphabetSize, int kmerSize, int maskMode, int maskLowerCase, int kmerThr, int splits);
+                                bool compBiasCorrection, int alphabetSize, int kmerSize, int maskMode, int maskLowerCase, int kmerThr, int splits, bool compressEntries);
 
     static DBReader<unsigned int> *openNewHeaderReader(DBReader<unsigned int>*dbr, unsigned int dataIdx, unsigned int indexIdx, int threads, bool touchIndex, bool touchData);
 
@@ -77,6 +80,8 @@ public:
 
     static std::string getSpacedPattern(DBReader<unsigned int> *dbr);
 
+    static bool isIndexTableCompressed(DBReader<unsigned int> *dbr);
+
     static ScoreMatrix get2MerScoreMatrix(DBReader<unsigned int> *dbr, int preloadMode);
 
     static ScoreMatrix get3MerScoreMatrix(DBReader<unsigned int> *dbr, int preloadMode);
@@ -1,6 +1,7 @@
 #include "SubstitutionMatrix.h"
 #include "QueryMatcher.h"
 #include "FastSort.h"
+#include "HugePageAllocator.h"
 #include "Util.h"
 
 #define FE_1(WHAT, X) WHAT(X)
@@ -23,7 +24,8 @@ QueryMatcher::QueryMatcher(IndexTable *indexTable, SequenceLookup *sequenceLooku
                            BaseMatrix *kmerSubMat, BaseMatrix *ungappedAlignmentSubMat,
                            short kmerThr, int kmerSize, size_t dbSize,
                            unsigned int maxSeqLen, size_t maxHitsPerQuery, bool aaBiasCorrection,
-                           bool diagonalScoring, unsigned int minDiagScoreThr, bool takeOnlyBestKmer, bool isNucleotide)
+                           bool diagonalScoring, unsigned int minDiagScoreThr, bool takeOnlyBestKmer, bool isNucleotide,
+                           bool batchShortQueries)
                             : idx(indexTable->getAlphabetSize(), kmerSize), isNucleotide(isNucleotide)
 {
     this->kmerSubMat = kmerSubMat;
@@ -43,11 +45,28 @@ QueryMatcher::QueryMatcher(IndexTable *indexTable, SequenceLookup *sequenceLooku
     // we can never find more hits than dbSize
     this->maxHitsPerQuery = std::min(maxHitsPerQuery, dbSize);
     this->resList = (hit_t *) mem_align(ALIGN_INT, maxHitsPerQuery * sizeof(hit_t) );
-    this->databaseHits = new(std::nothrow) IndexEntryLocal[maxDbMatches];
+    // the hit list and the diagonal counters are written at random positions, so they are backed by huge pages
+    this->databaseHits = HugePageAllocator::allocateArray<IndexEntryLocal>(maxDbMatches);
     Util::checkAllocation(databaseHits, "Can not allocate databaseHits memory in QueryMatcher");
-    this->foundDiagonals = (CounterResult*)calloc(foundDiagonalsSize, sizeof(CounterResult));
+    this->foundDiagonals = HugePageAllocator::allocateArray<CounterResult>(foundDiagonalsSize);
     Util::checkAllocation(foundDiagonals, "Can not allocate foundDiagonals memory in QueryMatcher");
     this->lastSequenceHit = this->databaseHits + maxDbMatches;
+    // the slot of a batch query is encoded in the target id
+    const size_t batchSize = getBatchSize(dbSize);
+    this->batchSlotBits = 0;
+    while ((static_cast<size_t>(1) << batchSlotBits) < batchSize) {
+        batchSlotBits++;
+    }
+    this->batchShortQueries = batchShortQueries && batchSize > 1;
+    this->batchCompositionBias = NULL;
+    this->batchDiagonals = NULL;
+    if (this->batchShortQueries) {
+        this->batchCompositionBias = new float[batchSize * BATCH_MAX_QUERY_LEN];
+        this->batchDiagonals = HugePageAllocator::allocateArray<CounterResult>(foundDiagonalsSize);
+        Util::checkAllocation(batchDiagonals, "Can not allocate batchDiagonals memory in QueryMatcher");
+        // the queries of a batch are placed one after another in indexPointer
+        maxSeqLen = std::max(maxSeqLen, static_cast<unsigned int>(batchSize * BATCH_MAX_QUERY_LEN));
+    }
     this->indexPointer = new(std::nothrow) IndexEntryLocal*[maxSeqLen + 1];
     Util::checkAllocation(indexPointer, "Can not allocate indexPointer memory in QueryMatcher");
     this->diagonalScoring = diagonalScoring;
@@ -57,6 +76,9 @@ QueryMatcher::QueryMatcher(IndexTable *indexTable, SequenceLookup *sequenceLooku
     memset(scoreSizes, 0, SCORE_RANGE * sizeof(unsigned int));
     // this array will need 128 * (maxDbMatches / 128) * 5byte ~ 500MB for 50 Mio. Sequences
     initDiagonalMatcher(dbSize, maxDbMatches);
+    if (this->batchShortQueries) {
+        initBatchDiagonalMatcher(dbSize << batchSlotBits, maxDbMatches);
+    }
 //    this->diagonalMatcher = new CacheFriendlyOperations(dbSize, maxDbMatches / 128 );
     // needed for p-value calc.
     ungappedAlignment = NULL;
@@ -68,12 +90,19 @@ QueryMatcher::QueryMatcher(IndexTable *indexTable, SequenceLookup *sequenceLooku
 
 QueryMatcher::~QueryMatcher(){
     deleteDiagonalMatcher(activeCounter);
+    if (batchShortQueries) {
+        deleteBatchDiagonalMatcher(batchActiveCounter);
+    }
     free(resList);
     delete[] scoreSizes;
-    delete[] databaseHits;
+    HugePageAllocator::deallocateArray(databaseHits, maxDbMatches);
     delete[] indexPointer;
-    free(foundDiagonals);
+    HugePageAllocator::deallocateArray(foundDiagonals, foundDiagonalsSize);
     delete[] compositionBias;
+    if (batchShortQueries) {
+        delete[] batchCompositionBias;
+        HugePageAllocator::deallocateArray(batchDiagonals, foundDiagonalsSize);
+    }
     if(ungappedAlignment != NULL){
         delete ungappedAlignment;
     }
@@ -86,18 +115,165 @@ std::pair<hit_t*, size_t> QueryMatcher::matchQuery(Sequence *querySeq, unsigned
 //    std::cout << "Id: " << querySeq->getId() << std::endl;
     memset(scoreSizes, 0, SCORE_RANGE * sizeof(unsigned int));
 
+    computeCompositionBias(querySeq, compositionBias);
+
+    size_t resultSize = match(querySeq, compositionBias);
+    return scoreHits(querySeq, compositionBias, resultSize, identityId, isNucleotide);
+}
+
+size_t QueryMatcher::matchQueryBatch(Sequence **querySeqs, size_t batchSize) {
+    IndexEntryLocal *sequenceHits = databaseHits;
+    size_t seqListSize;
+    size_t biasOffset = 0;
+    unsigned short position = 0;
+    for (size_t slot = 0; slot < batchSize; slot++) {
+        Sequence *seq = querySeqs[slot];
+        seq->resetCurrPos();
+        float *compositionBias = batchCompositionBias + biasOffset;
+        computeCompositionBias(seq, compositionBias);
+
+        BatchQuery &query = batchQueries[slot];
+        query.seq = seq;
+        query.biasOffset = biasOffset;
+        query.kmerListLen = 0;
+        query.dbMatches = 0;
+        biasOffset += seq->L;
+
+        bool hasKmer = false;
+        unsigned short lastPosition = position;
+        while (seq->hasNextKmer()) {
+            const unsigned char *kmer = seq->nextKmer();
+            const unsigned char *pos = seq->getAAPosInSpacedPattern();
+            const unsigned short current_i = seq->getCurrentPosition();
+            hasKmer = true;
+            lastPosition = position + current_i;
+            indexPointer[lastPosition] = sequenceHits;
+
+            float biasCorrection = 0;
+            for (int i = 0; i < kmerSize; i++){
+                biasCorrection += compositionBias[current_i + static_cast<short>(pos[i])];
+            }
+            if (seq->kmerContainsX()) {
+                continue;
+            }
+            short bias = static_cast<short>((biasCorrection < 0.0) ? biasCorrection - 0.5: biasCorrection + 0.5);
+            short kmerMatchScore = std::max(kmerThr - bias, 0);
+            kmerGenerator->setThreshold(kmerMatchScore);
+
+            const size_t *index;
+            size_t exactKmer;
+            size_t kmerElementSize;
+            if (takeOnlyBestKmer) {
+                kmerElementSize = 1;
+                exactKmer = idx.int2index(kmer);
+                index = &exactKmer;
+            } else {
+                std::pair<size_t*, size_t> kmerList = kmerGenerator->generateKmerList(kmer);
+                kmerElementSize = kmerList.second;
+                index = kmerList.first;
+            }
+            query.kmerListLen += kmerElementSize;
+
+            for (unsigned int kmerPos = 0; kmerPos < kmerElementSize; kmerPos++) {
+                // the exact size of a compressed list is only computed if its upper bound does not fit
+                seqListSize = indexTable->getDBSeqListMaxSize(index[kmerPos]);
+                if ((sequenceHits + seqListSize) >= lastSequenceHit) {
+                    seqListSize = indexTable->getDBSeqListSize(index[kmerPos]);
+                }
+                if ((sequenceHits + seqListSize) >= lastSequenceHit) {
+                    goto overflow;
+                }
+                seqListSize = indexTable->copyDBSeqList(index[kmerPos], sequenceHits);
+                for (size_t i = 0; i < seqListSize; i++) {
+                    sequenceHits[i].seqId = (sequenceHits[i].seqId << batchSlotBits) | static_cast<unsigned int>(slot);
+                    // shift the target position with the query, so the diagonal is the one of the query alone
+                    sequenceHits[i].position_j = static_cast<unsigned short>(sequenceHits[i].position_j + position);
+                }
+                sequenceHits += seqListSize;
+                query.dbMatches += seqListSize;
+            }
+        }
+        // like in match, the hits of the last k-mer position are not counted
+        // the next query starts at this position and replaces them
+        if (hasKmer) {
+            sequenceHits = indexPointer[lastPosition];
+            position = lastPosition;
+        }
+        continue;
+
+        overflow:
+        // end the batch before the query that did not fit, its hits are dropped
+        sequenceHits = indexPointer[position];
+        batchSize = slot;
+        break;
+    }
+    if (batchSize == 0) {
+        return 0;
+    }
+    indexPointer[position] = sequenceHits;
+
+    // a single pass over the hits of all queries
+    // k-mer matches of different queries never share a diagonal since their target ids differ in the slot bits
+    size_t hitCount = findBatchDuplicates(indexPointer, foundDiagonals, foundDiagonalsSize, 0, position, (diagonalScoring == false));
+    if (hitCount >= foundDiagonalsSize / 2) {
+        return 0;
+    }
+
+    // group the hits by slot and restore the target ids
+    const unsigned int slotMask = (1u << batchSlotBits) - 1;
+    memset(batchHitOffset, 0, sizeof(batchHitOffset));
+    for (size_t i = 0; i < hitCount; i++) {
+        batchHitOffset[(foundDiagonals[i].id & slotMask) + 1]++;
+    }
+    for (size_t slot = 0; slot < batchSize; slot++) {
+        batchHitOffset[slot + 1] += batchHitOffset[slot];
+    }
+    size_t writePos[MAX_BATCH_SIZE];
+    memcpy(writePos, batchHitOffset, sizeof(writePos));
+    for (size_t i = 0; i < hitCount; i++) {
+        const unsigned int slot = foundDiagonals[i].id & slotMask;
+        CounterResult &hit = batchDiagonals[writePos[slot]++];
+        hit.id = foundDiagonals[i].id >> batchSlotBits;
+        hit.count = foundDiagonals[i].count;
+        hit.diagonal = foundDiagonals[i].diagonal;
+    }
+    return batchSize;
+}
+
+std::pair<hit_t*, size_t> QueryMatcher::getBatchResult(size_t slot, unsigned int identityId, bool isNucleotide) {
+    const BatchQuery &query = batchQueries[slot];
+    const size_t resultSize = batchHitOffset[slot + 1] - batchHitOffset[slot];
+    memcpy(foundDiagonals, batchDiagonals + batchHitOffset[slot], resultSize * sizeof(CounterResult));
+
+    memset(scoreSizes, 0, SCORE_RANGE * sizeof(unsigned int));
+    stats->diagonalOverflow = false;
+    stats->doubleMatches = 0;
+    if (diagonalScoring == false) {
+        updateScoreBins(foundDiagonals, resultSize);
+        stats->doubleMatches = getDoubleDiagonalMatches();
+    }
+    stats->kmersPerPos = ((double)query.kmerListLen/(double)query.seq->L);
+    stats->querySeqLen = query.seq->L;
+    stats->dbMatches = query.dbMatches;
+
+    return scoreHits(query.seq, batchCompositionBias + query.biasOffset, resultSize, identityId, isNucleotide);
+}
+
+void QueryMatcher::computeCompositionBias(Sequence *seq, float *compositionBias) {
     // bias correction
     if(aaBiasCorrection == true){
-        if(Parameters::isEqualDbtype(querySeq->getSeqType(), Parameters::DBTYPE_AMINO_ACIDS)) {
-            SubstitutionMatrix::calcLocalAaBiasCorrection(kmerSubMat, querySeq->numSequence, querySeq->L, compositionBias);
+        if(Parameters::isEqualDbtype(seq->getSeqType(), Parameters::DBTYPE_AMINO_ACIDS)) {
+            SubstitutionMatrix::calcLocalAaBiasCorrection(kmerSubMat, seq->numSequence, seq->L, compositionBias);
         }else{
-            memset(compositionBias, 0, sizeof(float) * querySeq->L);
+            memset(compositionBias, 0, sizeof(float) * seq->L);
         }
     } else {
-        memset(compositionBias, 0, sizeof(float) * querySeq->L);
+        memset(compositionBias, 0, sizeof(float) * seq->L);
     }
+}
 
-    size_t resultSize = match(querySeq, compositionBias);
+std::pair<hit_t*, size_t> QueryMatcher::scoreHits(Sequence *querySeq, float *compositionBias, size_t resultSize,
+                                                  unsigned int identityId, bool isNucleotide) {
     std::pair<hit_t *, size_t> queryResult;
     if (diagonalScoring) {
         // write diagonal scores in count value
@@ -239,7 +415,11 @@ size_t QueryMatcher::match(Sequence *seq, float *compositionBias) {
         kmerListLen += kmerElementSize;
 
         for (unsigned int kmerPos = 0; kmerPos < kmerElementSize; kmerPos++) {
-            const IndexEntryLocal *entries = indexTable->getDBSeqList(index[kmerPos], &seqListSize);
+            // the exact size of a compressed list is only computed if its upper bound does not fit
+            seqListSize = indexTable->getDBSeqListMaxSize(index[kmerPos]);
+            if ((sequenceHits + seqListSize) >= lastSequenceHit) {
+                seqListSize = indexTable->getDBSeqListSize(index[kmerPos]);
+            }
             // DEBUG
             //std::cout << seq->getDbKey() << std::endl;
             //idx.printKmer(index[kmerPos], kmerSize, kmerSubMat->num2aa);
@@ -278,7 +458,7 @@ size_t QueryMatcher::match(Sequence *seq, float *compositionBias) {
                     goto outer;
                 }
             }
-            memcpy(sequenceHits, entries, sizeof(IndexEntryLocal) * seqListSize);
+            seqListSize = indexTable->copyDBSeqList(index[kmerPos], sequenceHits);
             sequenceHits += seqListSize;
             numMatches += seqListSize;
         }
@@ -380,34 +560,32 @@ std::pair<hit_t*, size_t> QueryMatcher::getResult(CounterResult * results,
     return std::make_pair(resList, currentHits);
 }
 
-void QueryMatcher::initDiagonalMatcher(size_t dbsize, unsigned int maxDbMatches) {
+unsigned int QueryMatcher::getDiagonalMatcherBinSize(size_t dbsize) {
+    // the duplicate array of dbsize / x bytes should fit into the L2 cache
     uint64_t l2CacheSize = Util::getL2CacheSize();
-#define INIT(x) cachedOperation##x = new CacheFriendlyOperations<x>(dbsize, maxDbMatches/x); \
-                activeCounter = x;
-    if(dbsize/2 < l2CacheSize){
-        INIT(2)
-    }else if(dbsize/4 < l2CacheSize){
-        INIT(4)
-    }else if(dbsize/8 < l2CacheSize){
-        INIT(8)
-    }else if(dbsize/16 < l2CacheSize){
-        INIT(16)
-    }else if(dbsize/32 < l2CacheSize){
-        INIT(32)
-    }else if(dbsize/64 < l2CacheSize){
-        INIT(64)
-    }else if(dbsize/128 < l2CacheSize){
-        INIT(128)
-    }else if(dbsize/256 < l2CacheSize){
-        INIT(256)
-    }else if(dbsize/512 < l2CacheSize){
-        INIT(512)
-    }else if(dbsize/1024 < l2CacheSize){
-        INIT(1024)
-    }else {
-        INIT(2048)
-    }
-#undef INIT
+    unsigned int binSize = 2;
+    while (binSize < 2048 && dbsize / binSize >= l2CacheSize) {
+        binSize *= 2;
+    }
+    return binSize;
+}
+
+void QueryMatcher::initDiagonalMatcher(size_t dbsize, unsigned int maxDbMatches) {
+    activeCounter = getDiagonalMatcherBinSize(dbsize);
+#define INIT_CASE(x) case x: cachedOperation##x = new CacheFriendlyOperations<x>(dbsize, maxDbMatches/x); break;
+    switch (activeCounter){
+        FOR_EACH(INIT_CASE,2,4,8,16,32,64,128,256,512,1024,2048)
+    }
+#undef INIT_CASE
+}
+
+void QueryMatcher::initBatchDiagonalMatcher(size_t dbsize, unsigned int maxDbMatches) {
+    batchActiveCounter = getDiagonalMatcherBinSize(dbsize);
+#define INIT_CASE(x) case x: cachedBatchOperation##x = new CacheFriendlyOperations<x>(dbsize, maxDbMatches/x); break;
+    switch (batchActiveCounter){
+        FOR_EACH(INIT_CASE,2,4,8,16,32,64,128,256,512,1024,2048)
+    }
+#undef INIT_CASE
 }
 
 void QueryMatcher::deleteDiagonalMatcher(unsigned int activeCounter){
@@ -418,6 +596,14 @@ void QueryMatcher::deleteDiagonalMatcher(unsigned int activeCounter){
 #undef DELETE_CASE
 }
 
+void QueryMatcher::deleteBatchDiagonalMatcher(unsigned int batchActiveCounter){
+#define DELETE_CASE(x) case x: delete cachedBatchOperation##x; break;
+    switch (batchActiveCounter){
+        FOR_EACH(DELETE_CASE,2,4,8,16,32,64,128,256,512,1024,2048)
+    }
+#undef DELETE_CASE
+}
+
 size_t QueryMatcher::findDuplicates(IndexEntryLocal **hitsByIndex,
                                    CounterResult *output, size_t outputSize,
                                    unsigned short indexFrom, unsigned short indexTo,
@@ -431,6 +617,19 @@ size_t QueryMatcher::findDuplicates(IndexEntryLocal **hitsByIndex,
     return localResultSize;
 }
 
+size_t QueryMatcher::findBatchDuplicates(IndexEntryLocal **hitsByIndex,
+                                         CounterResult *output, size_t outputSize,
+                                         unsigned short indexFrom, unsigned short indexTo,
+                                         bool computeTotalScore) {
+    size_t localResultSize = 0;
+#define COUNT_CASE(x) case x: localResultSize += cachedBatchOperation##x->findDuplicates(hitsByIndex, output, outputSize, indexFrom, indexTo, computeTotalScore); break;
+    switch (batchActiveCounter){
+        FOR_EACH(COUNT_CASE,2,4,8,16,32,64,128,256,512,1024,2048)
+    }
+#undef COUNT_CASE
+    return localResultSize;
+}
+
 size_t QueryMatcher::mergeElements(CounterResult *foundDiagonals, size_t hitCounter) {
     size_t overflowHitCount = 0;
 #define MERGE_CASE(x) \
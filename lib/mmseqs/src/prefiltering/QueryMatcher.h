@@ -56,13 +56,41 @@ public:
                  BaseMatrix *kmerSubMat, BaseMatrix *ungappedAlignmentSubMat,
                  short kmerThr, int kmerSize, size_t dbSize, unsigned int maxSeqLen,
                  size_t maxHitsPerQuery, bool aaBiasCorrection, bool diagonalScoringMode,
-                 unsigned int minDiagScoreThr, bool takeOnlyBestKmer, bool isNucleotide);
+                 unsigned int minDiagScoreThr, bool takeOnlyBestKmer, bool isNucleotide, bool batchShortQueries = false);
     ~QueryMatcher();
 
+    // short queries (e.g. the six-frame ORF fragments of a contig) can be matched in batches of up to MAX_BATCH_SIZE queries
+    // the slot of a query in the batch is stored in the lower bits of the target ids while matching
+    static const unsigned int MAX_BATCH_SLOT_BITS = 8;
+    static const size_t MAX_BATCH_SIZE = (1 << MAX_BATCH_SLOT_BITS);
+    static const unsigned int BATCH_MAX_QUERY_LEN = 64;
+
     // returns result for the sequence
     // identityId is the id of the identitical sequence in the target database if there is any, UINT_MAX otherwise
     std::pair<hit_t*, size_t> matchQuery(Sequence *querySeq, unsigned int identityId,  bool isNucleotide);
 
+    // matches up to getBatchSize(dbSize) queries of at most BATCH_MAX_QUERY_LEN residues in a single k-mer matching pass
+    // returns the number of leading queries that were matched, the batch ends early if the k-mer hits would overflow
+    // 0 is returned if the first query alone overflows, it has to be matched by matchQuery then
+    size_t matchQueryBatch(Sequence **querySeqs, size_t batchSize);
+
+    // returns result for the query in the slot of the last matched batch
+    // the result stays valid until the next call to getBatchResult or matchQuery
+    std::pair<hit_t*, size_t> getBatchResult(size_t slot, unsigned int identityId, bool isNucleotide);
+
+    bool canBatchQueries() {
+        return batchShortQueries;
+    }
+
+    // the number of slots that fit next to the target ids of a database with dbSize entries
+    static size_t getBatchSize(size_t dbSize) {
+        unsigned int slotBits = MAX_BATCH_SLOT_BITS;
+        while (slotBits > 0 && dbSize > (UINT_MAX >> slotBits)) {
+            slotBits--;
+        }
+        return static_cast<size_t>(1) << slotBits;
+    }
+
     // set substituion matrix for KmerGenerator
     void setProfileMatrix(ScoreMatrix **matrix){
         kmerGenerator->setDivideStrategy(matrix);
@@ -192,6 +220,26 @@ protected:
 
     bool isNucleotide;
 
+    // batched matching of short queries
+    bool batchShortQueries;
+    unsigned int batchSlotBits;
+
+    struct BatchQuery {
+        Sequence *seq;
+        // start of the query in batchCompositionBias
+        size_t biasOffset;
+        size_t kmerListLen;
+        size_t dbMatches;
+    };
+    BatchQuery batchQueries[MAX_BATCH_SIZE];
+
+    // composition bias of the batch queries, one after another
+    float *batchCompositionBias;
+
+    // hits of the last batch grouped by slot, batchHitOffset[slot] is the first hit of a slot
+    CounterResult *batchDiagonals;
+    size_t batchHitOffset[MAX_BATCH_SIZE + 1];
+
     const static size_t SCORE_RANGE = 256;
 
     void updateScoreBins(CounterResult *result, size_t elementCount);
@@ -208,9 +256,15 @@ protected:
         return scoreThr;
     }
 
+    void computeCompositionBias(Sequence *seq, float *compositionBias);
+
     // match sequence against the IndexTable
     size_t match(Sequence *seq, float *compositionBias);
 
+    // compute the prefilter scores of the resultSize hits in foundDiagonals and extract the best ones
+    std::pair<hit_t *, size_t> scoreHits(Sequence *querySeq, float *compositionBias, size_t resultSize,
+                                         unsigned int identityId, bool isNucleotide);
+
     // extract result from databaseHits
     template <int TYPE>
     std::pair<hit_t *, size_t> getResult(CounterResult * results,
@@ -229,7 +283,8 @@ protected:
     std::pair<size_t, unsigned int> rescoreHits(Sequence * querySeq, unsigned int *scoreSizes, CounterResult *results,
                                                 size_t resultSize, UngappedAlignment *align, int lowerBoundScore);
 
-#define CacheFriendlyOperations(x)  CacheFriendlyOperations<x> * cachedOperation##x
+#define CacheFriendlyOperations(x)  CacheFriendlyOperations<x> * cachedOperation##x; \
+                                    CacheFriendlyOperations<x> * cachedBatchOperation##x
     CacheFriendlyOperations(2);
     CacheFriendlyOperations(4);
     CacheFriendlyOperations(8);
@@ -243,14 +298,26 @@ protected:
     CacheFriendlyOperations(2048);
 #undef CacheFriendlyOperations
 
+    // bins of the diagonal matcher of the batch queries, their target ids contain the slot
+    unsigned int batchActiveCounter;
+
+    static unsigned int getDiagonalMatcherBinSize(size_t dbsize);
+
     void initDiagonalMatcher(size_t dbsize, unsigned int maxDbMatches);
 
+    void initBatchDiagonalMatcher(size_t dbsize, unsigned int maxDbMatches);
+
     void deleteDiagonalMatcher(unsigned int activeCounter);
 
+    void deleteBatchDiagonalMatcher(unsigned int batchActiveCounter);
+
     // find duplicates in the diagonal bins
     size_t findDuplicates(IndexEntryLocal **hitsByIndex, CounterResult *output,
                           size_t outputSize, unsigned short indexFrom, unsigned short indexTo, bool computeTotalScore);
 
+    size_t findBatchDuplicates(IndexEntryLocal **hitsByIndex, CounterResult *output,
+                               size_t outputSize, unsigned short indexFrom, unsigned short indexTo, bool computeTotalScore);
+
 
     size_t mergeElements(CounterResult *foundDiagonals, size_t hitCounter);
 
@@ -15,21 +15,8 @@
 
 const int NcbiTaxonomy::SERIALIZATION_VERSION = 2;
 
-int **makeMatrix(size_t maxNodes) {
-    size_t dimension = maxNodes * 2;
-    int **M = new int*[dimension];
-    int k = (int)(MathUtil::flog2(dimension)) + 1;
-    M[0] = new int[dimension * k]();
-    for(size_t i = 1; i < dimension; i++) {
-        M[i] = M[i-1] + k;
-    }
-
-    return M;
-}
-
-void deleteMatrix(int** M) {
-    delete[] M[0];
-    delete[] M;
+size_t matrixWidth(size_t maxNodes) {
+    return (size_t)(MathUtil::flog2(maxNodes * 2)) + 1;
 }
 
 NcbiTaxonomy::NcbiTaxonomy(const std::string &namesFile, const std::string &nodesFile, const std::string &mergedFile) : externalData(false) {
@@ -68,7 +55,8 @@ NcbiTaxonomy::NcbiTaxonomy(const std::string &namesFile, const std::string &node
     L = new int[maxNodes * 2];
     std::copy(tmpL.begin(), tmpL.end(), L);
 
-    M = makeMatrix(maxNodes);
+    MK = matrixWidth(maxNodes);
+    M = new int[(maxNodes * 2) * MK]();
     InitRangeMinimumQuery();
 
     mmapData = NULL;
@@ -76,15 +64,13 @@ NcbiTaxonomy::NcbiTaxonomy(const std::string &namesFile, const std::string &node
 }
 
 NcbiTaxonomy::~NcbiTaxonomy() {
-    if (externalData) {
-        delete[] M;
-    } else {
+    if (externalData == false) {
         delete[] taxonNodes;
         delete[] H;
         delete[] D;
         delete[] E;
         delete[] L;
-        deleteMatrix(M);
+        delete[] M;
     }
     delete block;
     if (mmapData != NULL) {
@@ -207,17 +193,17 @@ void NcbiTaxonomy::InitRangeMinimumQuery() {
     Debug(Debug::INFO) << "Init RMQ ...";
 
     for (unsigned int i = 0; i < (maxNodes * 2); ++i) {
-        M[i][0] = i;
+        M[i * MK] = i;
     }
 
     for (unsigned int j = 1; (1ul << j) <= (maxNodes * 2); ++j) {
         for (unsigned int i = 0; (i + (1ul << j) - 1) < (maxNodes * 2); ++i) {
-            int A = M[i][j - 1];
-            int B = M[i + (1ul << (j - 1))][j - 1];
+            int A = M[i * MK + j - 1];
+            int B = M[(i + (1ul << (j - 1))) * MK + j - 1];
             if (L[A] < L[B]) {
-                M[i][j] = A;
+                M[i * MK + j] = A;
             } else {
-                M[i][j] = B;
+                M[i * MK + j] = B;
             }
         }
     }
@@ -227,8 +213,8 @@ void NcbiTaxonomy::InitRangeMinimumQuery() {
 int NcbiTaxonomy::RangeMinimumQuery(int i, int j) const {
     assert(j >= i);
     int k = (int)MathUtil::flog2(j - i + 1);
-    int A = M[i][k];
-    int B = M[j - MathUtil::ipow<int>(2, k) + 1][k];
+    int A = M[i * MK + k];
+    int B = M[(j - MathUtil::ipow<int>(2, k) + 1) * MK + k];
     if (L[A] <= L[B]) {
         return A;
     }
@@ -703,9 +689,7 @@ WeightedTaxResult NcbiTaxonomy::weightedMajorityLCA(const std::vector<WeightedTa
 
 std::pair<char*, size_t> NcbiTaxonomy::serialize(const NcbiTaxonomy& t) {
     t.block->compact();
-    size_t matrixDim = (t.maxNodes * 2);
-    size_t matrixK = (int)(MathUtil::flog2(matrixDim)) + 1;
-    size_t matrixSize = matrixDim * matrixK * sizeof(int);
+    size_t matrixSize = (t.maxNodes * 2) * t.MK * sizeof(int);
     size_t blockSize = StringBlock<unsigned int>::memorySize(*t.block);
     size_t memSize = sizeof(int) // SERIALIZATION_VERSION
         + sizeof(size_t) // maxNodes
@@ -735,7 +719,7 @@ std::pair<char*, size_t> NcbiTaxonomy::serialize(const NcbiTaxonomy& t) {
     p += (t.maxNodes * 2) * sizeof(int);
     memcpy(p, t.H, t.maxNodes * sizeof(int));
     p += t.maxNodes * sizeof(int);
-    memcpy(p, t.M[0], matrixSize);
+    memcpy(p, t.M, matrixSize);
     p += matrixSize;
     char* blockData = StringBlock<unsigned int>::serialize(*t.block);
     memcpy(p, blockData, blockSize);
@@ -765,15 +749,10 @@ NcbiTaxonomy* NcbiTaxonomy::unserialize(char* mem) {
     p += (maxNodes * 2) * sizeof(int);
     int* H = (int*)p;
     p += maxNodes * sizeof(int);
-    size_t matrixDim = (maxNodes * 2);
-    size_t matrixK = (int)(MathUtil::flog2(matrixDim)) + 1;
-    size_t matrixSize = matrixDim * matrixK * sizeof(int);
-    int** M = new int*[matrixDim];
-    M[0] = (int*)p;
-    for(size_t i = 1; i < matrixDim; i++) {
-        M[i] = M[i-1] + matrixK;
-    }
-    p += matrixSize;
+    // the sparse table is stored flat, so it can be used directly from the mapped image
+    size_t MK = matrixWidth(maxNodes);
+    int* M = (int*)p;
+    p += (maxNodes * 2) * MK * sizeof(int);
     StringBlock<unsigned int>* block = StringBlock<unsigned int>::unserialize(p);
-    return new NcbiTaxonomy(taxonNodes, maxNodes, maxTaxID, D, E, L, H, M, block);
+    return new NcbiTaxonomy(taxonNodes, maxNodes, maxTaxID, D, E, L, H, M, MK, block);
 }
@@ -134,14 +134,15 @@ private:
     int RangeMinimumQuery(int i, int j) const;
     int lcaHelper(int i, int j) const;
 
-    NcbiTaxonomy(TaxonNode* taxonNodes, size_t maxNodes, int maxTaxID, int *D, int *E, int *L, int *H, int **M, StringBlock<unsigned int> *block)
-        : taxonNodes(taxonNodes), maxNodes(maxNodes), maxTaxID(maxTaxID), D(D), E(E), L(L), H(H), M(M), block(block), externalData(true), mmapData(NULL), mmapSize(0) {};
+    NcbiTaxonomy(TaxonNode* taxonNodes, size_t maxNodes, int maxTaxID, int *D, int *E, int *L, int *H, int *M, size_t MK, StringBlock<unsigned int> *block)
+        : taxonNodes(taxonNodes), maxNodes(maxNodes), maxTaxID(maxTaxID), D(D), E(E), L(L), H(H), M(M), MK(MK), block(block), externalData(true), mmapData(NULL), mmapSize(0) {};
     int maxTaxID;
     int *D; // maps from taxID to node ID in taxonNodes
     int *E; // for Euler tour sequence (size 2N-1)
     int *L; // Level of nodes in tour sequence (size 2N-1)
     int *H;
-    int **M;
+    int *M; // sparse table for RMQ, (2N) rows of MK entries
+    size_t MK;
     StringBlock<unsigned int>* block;
 
     bool externalData;
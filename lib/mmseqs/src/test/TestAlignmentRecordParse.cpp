@@ -0,0 +1,83 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Matcher.h"
+#include "Timer.h"
+#include "Util.h"
+
+const char* binary_name = "test_alignmentrecordparse";
+
+int main (int, const char**) {
+    const size_t recordCount = 2000000;
+    std::string data;
+    char buffer[1024];
+    for (size_t i = 0; i < recordCount; ++i) {
+        Matcher::result_t res(i, 100 + (i % 50), 0.9, 0.8, 0.654, 1.2e-20, 120, 3, 120, 150, 10, 130, 300,
+                              Matcher::compressAlignment(std::string(60, 'M') + "II" + std::string(58, 'M')));
+        size_t len = Matcher::resultToBuffer(buffer, res, true, true);
+        data.append(buffer, len);
+    }
+
+    Timer timer;
+    size_t checksum = 0;
+    char *pos = &data[0];
+    while (*pos != '\0') {
+        Matcher::result_t res = Matcher::parseAlignmentRecord(pos, true);
+        checksum += res.dbKey + res.backtrace.size();
+        pos = Util::skipLine(pos);
+    }
+    std::cout << "full records:      " << timer.lap() << " (" << checksum << ")" << std::endl;
+    timer.reset();
+
+    checksum = 0;
+    Matcher::result_view_t view;
+    pos = &data[0];
+    while (*pos != '\0') {
+        Matcher::parseAlignmentRecord(pos, Matcher::COLUMN_ALL, view);
+        checksum += view.dbKey + view.backtraceLength;
+        pos = Util::skipLine(pos);
+    }
+    std::cout << "all columns:       " << timer.lap() << " (" << checksum << ")" << std::endl;
+    timer.reset();
+
+    checksum = 0;
+    pos = &data[0];
+    while (*pos != '\0') {
+        Matcher::parseAlignmentRecord(pos, Matcher::COLUMN_KEY | Matcher::COLUMN_SCORE | Matcher::COLUMN_QUERY_POS | Matcher::COLUMN_TARGET_POS, view);
+        checksum += view.dbKey + view.backtraceLength;
+        pos = Util::skipLine(pos);
+    }
+    std::cout << "positions, score:  " << timer.lap() << " (" << checksum << ")" << std::endl;
+    timer.reset();
+
+    checksum = 0;
+    pos = &data[0];
+    while (*pos != '\0') {
+        Matcher::parseAlignmentRecord(pos, Matcher::COLUMN_KEY, view);
+        checksum += view.dbKey + view.backtraceLength;
+        pos = Util::skipLine(pos);
+    }
+    std::cout << "key only:          " << timer.lap() << " (" << checksum << ")" << std::endl;
+
+    // the columns of the view have to match the full parser for every record
+    size_t mismatches = 0;
+    pos = &data[0];
+    while (*pos != '\0') {
+        Matcher::result_t res = Matcher::parseAlignmentRecord(pos, true);
+        Matcher::parseAlignmentRecord(pos, Matcher::COLUMN_ALL, view);
+        if (res.dbKey != view.dbKey || res.score != view.score || res.seqId != view.seqId || res.eval != view.eval
+            || res.qStartPos != view.qStartPos || res.qEndPos != view.qEndPos || res.qLen != view.qLen
+            || res.dbStartPos != view.dbStartPos || res.dbEndPos != view.dbEndPos || res.dbLen != view.dbLen
+            || res.backtrace != std::string(view.backtrace, view.backtraceLength)) {
+            if (mismatches == 0) {
+                std::cout << "record of " << res.dbKey << " parsed as " << view.dbKey << " " << view.score << " "
+                          << view.qStartPos << "-" << view.qEndPos << " " << view.dbStartPos << "-" << view.dbEndPos << std::endl;
+            }
+            mismatches++;
+        }
+        pos = Util::skipLine(pos);
+    }
+    std::cout << "mismatching records: " << mismatches << std::endl;
+    return (mismatches == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,112 @@
+// Diagonal counting of short queries (few k-mer hits per query) against a large database:
+// checks that a reused CacheFriendlyOperations gives the results of a fresh one
+// and compares its time per query with a reset of the whole duplicate array
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+
+#include "CacheFriendlyOperations.h"
+#include "Timer.h"
+
+const char* binary_name = "test_cachefriendlyoperations";
+
+// about a fragment of 40 residues
+const size_t QUERY_LEN = 40;
+
+struct Query {
+    std::vector<IndexEntryLocal> hits;
+    IndexEntryLocal *positions[QUERY_LEN + 1];
+};
+
+void makeQuery(Query &query, size_t dbSize, size_t hitsPerPosition, size_t &state) {
+    query.hits.resize(QUERY_LEN * hitsPerPosition);
+    for (size_t i = 0; i < query.hits.size(); i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        // a few targets are hit repeatedly on the same diagonal
+        const size_t position = i / hitsPerPosition;
+        const bool repeated = (state % 4) == 0;
+        query.hits[i].seqId = repeated ? (state >> 8) % 64 : state % dbSize;
+        query.hits[i].position_j = repeated ? position : (state >> 32) % 1000;
+    }
+    for (size_t i = 0; i <= QUERY_LEN; i++) {
+        query.positions[i] = query.hits.data() + i * hitsPerPosition;
+    }
+}
+
+template<unsigned int BINSIZE>
+size_t countQuery(CacheFriendlyOperations<BINSIZE> &counter, Query &query, CounterResult *output, size_t outputSize) {
+    size_t hitCount = counter.findDuplicates(query.positions, output, outputSize, 0, QUERY_LEN, true);
+    return counter.keepMaxScoreElementOnly(output, hitCount);
+}
+
+bool equalResults(const CounterResult *a, const CounterResult *b, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        if (a[i].id != b[i].id || a[i].count != b[i].count || a[i].diagonal != b[i].diagonal) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<unsigned int BINSIZE>
+void runBenchmark(size_t dbSize, size_t hitsPerPosition, size_t queries) {
+    const size_t outputSize = QUERY_LEN * hitsPerPosition * 2;
+    CounterResult *output = new CounterResult[outputSize];
+    CounterResult *expected = new CounterResult[outputSize];
+    std::vector<Query> batch(queries);
+    size_t state = 42;
+    for (size_t i = 0; i < queries; i++) {
+        makeQuery(batch[i], dbSize, hitsPerPosition, state);
+    }
+
+    CacheFriendlyOperations<BINSIZE> counter(dbSize, outputSize / BINSIZE);
+    size_t mismatches = 0;
+    for (size_t i = 0; i < std::min(queries, static_cast<size_t>(100)); i++) {
+        CacheFriendlyOperations<BINSIZE> fresh(dbSize, outputSize / BINSIZE);
+        const size_t expectedSize = countQuery(fresh, batch[i], expected, outputSize);
+        const size_t size = countQuery(counter, batch[i], output, outputSize);
+        mismatches += (size != expectedSize || equalResults(output, expected, size) == false) ? 1 : 0;
+    }
+
+    Timer timer;
+    size_t checksum = 0;
+    for (size_t i = 0; i < queries; i++) {
+        checksum += countQuery(counter, batch[i], output, outputSize);
+    }
+    const double countSeconds = timer.getTimediff();
+
+    // the reset every query paid for before, once for findDuplicates and once for keepMaxScoreElementOnly
+    size_t size = 1;
+    while (size < dbSize) {
+        size *= 2;
+    }
+    std::vector<unsigned char> duplicateArray(std::max(size / BINSIZE, static_cast<size_t>(1)));
+    timer.reset();
+    for (size_t i = 0; i < queries; i++) {
+        memset(duplicateArray.data(), 0, duplicateArray.size());
+        memset(duplicateArray.data(), 0, duplicateArray.size());
+        checksum += duplicateArray[i % duplicateArray.size()];
+    }
+    const double resetSeconds = timer.getTimediff();
+
+    std::cout << dbSize << "\t" << BINSIZE << "\t" << QUERY_LEN * hitsPerPosition << "\t"
+              << (countSeconds * 1e6 / queries) << "\t" << (resetSeconds * 1e6 / queries) << "\t"
+              << mismatches << "\t" << checksum << std::endl;
+    delete[] output;
+    delete[] expected;
+}
+
+int main(int, const char **) {
+    std::cout << "dbSize\tbins\thits\tus/query\tfull reset us/query\tmismatches\tchecksum" << std::endl;
+    // bin counts as QueryMatcher::getDiagonalMatcherBinSize chooses them for a 2 MB L2 cache
+    runBenchmark<2>(300000, 4, 20000);
+    runBenchmark<2>(300000, 64, 20000);
+    runBenchmark<16>(20000000, 4, 20000);
+    runBenchmark<16>(20000000, 64, 20000);
+    runBenchmark<64>(100000000, 4, 20000);
+    runBenchmark<64>(100000000, 64, 20000);
+    return EXIT_SUCCESS;
+}
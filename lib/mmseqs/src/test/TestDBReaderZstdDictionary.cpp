@@ -0,0 +1,92 @@
+// Writes a result database with a trained zstd dictionary (--compressed 2) and reads
+// a dictionary entry, a plain entry and a dictionary entry again on the same thread
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+#include "DBReader.h"
+#include "DBWriter.h"
+#include "Parameters.h"
+#include "FileUtil.h"
+#include "Util.h"
+
+const char* binary_name = "test_dbreader_zstd_dictionary";
+
+// alignment result like lines, similar enough across entries for the dictionary to be used
+std::string makeEntry(size_t entry, size_t &state) {
+    std::string result;
+    for (size_t line = 0; line < 12; line++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        result.append(SSTR(entry * 100 + line));
+        result.append("\t");
+        result.append(SSTR(state % 1000));
+        result.append("\t0.");
+        result.append(SSTR(state % 97));
+        result.append("\t1.234E-");
+        result.append(SSTR(state % 30));
+        result.append("\t12\t345\t678\t9\t10\t11\t12\t-\n");
+    }
+    return result;
+}
+
+unsigned int frameDictId(DBReader<unsigned int> &reader, size_t id) {
+    const char *data = reader.getDataUncompressed(id);
+    unsigned int cSize = *(reinterpret_cast<const unsigned int *>(data));
+    return ZSTD_getDictID_fromFrame(data + sizeof(unsigned int), cSize);
+}
+
+int main(int, const char**) {
+    const std::string db = "dataZstdDictionary";
+    DBWriter writer(db.c_str(), (db + ".index").c_str(), 1, Parameters::WRITER_COMPRESSED_DICTIONARY_MODE, Parameters::DBTYPE_ALIGNMENT_RES);
+    writer.open();
+    std::vector<std::string> entries;
+    size_t state = 42;
+    for (size_t i = 0; i < 600; i++) {
+        entries.emplace_back(makeEntry(i, state));
+        writer.writeData(entries.back().c_str(), entries.back().size(), i, 0);
+    }
+    writer.close();
+
+    DBReader<unsigned int> reader(db.c_str(), (db + ".index").c_str(), 1, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
+    reader.open(DBReader<unsigned int>::NOSORT);
+
+    size_t plainEntry = SIZE_MAX;
+    size_t dictionaryEntry = SIZE_MAX;
+    for (size_t i = 0; i < reader.getSize(); i++) {
+        const unsigned int dictId = frameDictId(reader, i);
+        if (dictId == 0 && plainEntry == SIZE_MAX) {
+            plainEntry = i;
+        } else if (dictId != 0) {
+            dictionaryEntry = i;
+        }
+    }
+    if (plainEntry == SIZE_MAX || dictionaryEntry == SIZE_MAX) {
+        std::cout << "expected plain and dictionary frames, found plain entry " << plainEntry
+                  << " and dictionary entry " << dictionaryEntry << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // the stream of thread 0 switches from the dictionary to none and back
+    const size_t order[] = { dictionaryEntry, plainEntry, dictionaryEntry - 1, plainEntry + 1 };
+    size_t mismatches = 0;
+    for (size_t i = 0; i < sizeof(order) / sizeof(order[0]); i++) {
+        const size_t id = order[i];
+        const unsigned int key = reader.getDbKey(id);
+        const std::string data(reader.getData(id, 0));
+        if (data != entries[key]) {
+            std::cout << "entry " << key << " (dictionary id " << frameDictId(reader, id) << ") does not match the written data" << std::endl;
+            mismatches++;
+        }
+    }
+    reader.close();
+
+    FileUtil::remove(db.c_str());
+    FileUtil::remove((db + ".index").c_str());
+    FileUtil::remove((db + ".dbtype").c_str());
+    FileUtil::remove((db + ".dict").c_str());
+    std::cout << "mismatching entries\t" << mismatches << std::endl;
+    return (mismatches == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
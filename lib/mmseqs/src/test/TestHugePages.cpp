@@ -0,0 +1,184 @@
+// Checks that the HugePageAllocator returns zeroed memory and keeps the contents across reallocate, then
+// compares prefilter-like random accesses (k-mer offsets, index entries, diagonal counters)
+// on heap memory and on memory of the HugePageAllocator
+#include <iostream>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include "HugePageAllocator.h"
+#include "IndexTable.h"
+#include "CacheFriendlyOperations.h"
+#include "Timer.h"
+
+const char* binary_name = "test_hugepages";
+
+struct PrefilterArrays {
+    size_t *offsets;
+    IndexEntryLocal *entries;
+    CounterResult *counters;
+};
+
+void fillArrays(PrefilterArrays &arrays, size_t tableSize, size_t entryCount, size_t dbSize) {
+    const size_t entriesPerKmer = entryCount / tableSize;
+    for (size_t i = 0; i <= tableSize; i++) {
+        arrays.offsets[i] = i * entriesPerKmer;
+    }
+    size_t state = 42;
+    for (size_t i = 0; i < entryCount; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        arrays.entries[i].seqId = state % dbSize;
+        arrays.entries[i].position_j = state % 1000;
+    }
+    memset(arrays.counters, 0, dbSize * sizeof(CounterResult));
+}
+
+// looks up random k-mers and counts the diagonals of their entries, as QueryMatcher does
+size_t countDiagonals(const PrefilterArrays &arrays, size_t tableSize, size_t kmerLookups) {
+    size_t state = 7;
+    size_t checksum = 0;
+    for (size_t i = 0; i < kmerLookups; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        const size_t kmer = state % tableSize;
+        const size_t queryPos = i % 1000;
+        for (size_t j = arrays.offsets[kmer]; j < arrays.offsets[kmer + 1]; j++) {
+            CounterResult &counter = arrays.counters[arrays.entries[j].seqId];
+            const unsigned short diagonal = static_cast<unsigned short>(queryPos - arrays.entries[j].position_j);
+            counter.count += (counter.diagonal == diagonal);
+            counter.diagonal = diagonal;
+        }
+        checksum += arrays.offsets[kmer];
+    }
+    return checksum;
+}
+
+bool isZero(const char *ptr, size_t from, size_t to) {
+    for (size_t i = from; i < to; i++) {
+        if (ptr[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool hasPattern(const char *ptr, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        if (ptr[i] != static_cast<char>(i % 251 + 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void fillPattern(char *ptr, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        ptr[i] = static_cast<char>(i % 251 + 1);
+    }
+}
+
+bool isAligned(const void *ptr) {
+    return reinterpret_cast<uintptr_t>(ptr) % HugePageAllocator::HUGE_PAGE_SIZE == 0;
+}
+
+// grows and shrinks an allocation through the calloc path (< 2 MB) and the mapping path,
+// including a shrink and regrowth within the same huge pages
+size_t checkAllocations() {
+    size_t failures = 0;
+    const size_t sizes[] = { 1000, 500000, 1500000, 3000000, 3500000, 2500000, 4000000, 40000000, 6000000, 1000000, 100 };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        char *ptr = static_cast<char *>(HugePageAllocator::allocate(sizes[i]));
+        if (ptr == NULL || isZero(ptr, 0, sizes[i]) == false) {
+            std::cout << "allocate(" << sizes[i] << ") did not return zeroed memory" << std::endl;
+            failures++;
+        }
+        HugePageAllocator::deallocate(ptr, sizes[i]);
+    }
+
+    // mappings are aligned to huge pages unless huge pages are turned off
+    char *probe = static_cast<char *>(HugePageAllocator::allocate(sizes[3]));
+    const bool mappingsAligned = isAligned(probe);
+    // blocks growth in place of the allocation below, so that it has to move
+    char *blocker = static_cast<char *>(HugePageAllocator::allocate(sizes[3]));
+
+    char *ptr = static_cast<char *>(HugePageAllocator::allocate(sizes[0]));
+    fillPattern(ptr, sizes[0]);
+    for (size_t i = 1; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        const size_t oldSize = sizes[i - 1];
+        const size_t newSize = sizes[i];
+        char *newPtr = static_cast<char *>(HugePageAllocator::reallocate(ptr, oldSize, newSize));
+        if (newPtr == NULL) {
+            std::cout << "reallocate(" << oldSize << ", " << newSize << ") failed" << std::endl;
+            failures++;
+            break;
+        }
+        ptr = newPtr;
+        if (hasPattern(ptr, std::min(oldSize, newSize)) == false) {
+            std::cout << "reallocate(" << oldSize << ", " << newSize << ") did not keep the contents" << std::endl;
+            failures++;
+        }
+        if (newSize > oldSize && isZero(ptr, oldSize, newSize) == false) {
+            std::cout << "reallocate(" << oldSize << ", " << newSize << ") did not zero the new memory" << std::endl;
+            failures++;
+        }
+        if (mappingsAligned && newSize >= HugePageAllocator::HUGE_PAGE_SIZE && isAligned(ptr) == false) {
+            std::cout << "reallocate(" << oldSize << ", " << newSize << ") is not aligned to huge pages" << std::endl;
+            failures++;
+        }
+        fillPattern(ptr, newSize);
+    }
+    HugePageAllocator::deallocate(ptr, sizes[sizeof(sizes) / sizeof(sizes[0]) - 1]);
+    HugePageAllocator::deallocate(blocker, sizes[3]);
+    HugePageAllocator::deallocate(probe, sizes[3]);
+    std::cout << "allocation checks failed\t" << failures << std::endl;
+    return failures;
+}
+
+int main(int argc, const char **argv) {
+    if (checkAllocations() != 0) {
+        return EXIT_FAILURE;
+    }
+
+    // about the table of a 20 letter alphabet and k = 6
+    const size_t tableSize = (argc > 1) ? strtoull(argv[1], NULL, 10) : 64000000;
+    const size_t entryCount = tableSize * 2;
+    const size_t dbSize = 20000000;
+    const size_t kmerLookups = 20000000;
+
+    PrefilterArrays heap;
+    heap.offsets = new size_t[tableSize + 1];
+    heap.entries = new IndexEntryLocal[entryCount];
+    heap.counters = new CounterResult[dbSize];
+    fillArrays(heap, tableSize, entryCount, dbSize);
+
+    PrefilterArrays huge;
+    huge.offsets = HugePageAllocator::allocateArray<size_t>(tableSize + 1);
+    huge.entries = HugePageAllocator::allocateArray<IndexEntryLocal>(entryCount);
+    huge.counters = HugePageAllocator::allocateArray<CounterResult>(dbSize);
+    Util::checkAllocation(huge.offsets, "Can not allocate offsets");
+    Util::checkAllocation(huge.entries, "Can not allocate entries");
+    Util::checkAllocation(huge.counters, "Can not allocate counters");
+    fillArrays(huge, tableSize, entryCount, dbSize);
+
+    std::cout << "memory\tseconds\tchecksum" << std::endl;
+    for (size_t round = 0; round < 3; round++) {
+        Timer timer;
+        size_t checksum = countDiagonals(heap, tableSize, kmerLookups);
+        std::cout << "heap\t" << timer.getTimediff() << "\t" << checksum << std::endl;
+        timer.reset();
+        checksum = countDiagonals(huge, tableSize, kmerLookups);
+        std::cout << "huge pages\t" << timer.getTimediff() << "\t" << checksum << std::endl;
+    }
+
+    delete[] heap.offsets;
+    delete[] heap.entries;
+    delete[] heap.counters;
+    HugePageAllocator::deallocateArray(huge.offsets, tableSize + 1);
+    HugePageAllocator::deallocateArray(huge.entries, entryCount);
+    HugePageAllocator::deallocateArray(huge.counters, dbSize);
+    return EXIT_SUCCESS;
+}
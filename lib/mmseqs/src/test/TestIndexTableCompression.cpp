@@ -0,0 +1,89 @@
+// Builds the index table of a sequence database uncompressed and compressed,
+// checks that every k-mer list decodes to the uncompressed list
+// and compares the memory and the time of reading all lists
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+
+#include "SubstitutionMatrix.h"
+#include "IndexTable.h"
+#include "IndexBuilder.h"
+#include "SequenceLookup.h"
+#include "Parameters.h"
+#include "Timer.h"
+
+const char* binary_name = "test_indextablecompression";
+
+size_t readAllLists(IndexTable &table, IndexEntryLocal *buffer) {
+    size_t checksum = 0;
+    for (size_t kmer = 0; kmer < table.getTableSize(); kmer++) {
+        const size_t size = table.copyDBSeqList(kmer, buffer);
+        for (size_t i = 0; i < size; i++) {
+            checksum += buffer[i].seqId + buffer[i].position_j;
+        }
+    }
+    return checksum;
+}
+
+int main(int argc, const char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << binary_name << " <sequenceDB> [k-mer size]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const int kmerSize = (argc > 2) ? atoi(argv[2]) : 6;
+    Parameters &par = Parameters::getInstance();
+    SubstitutionMatrix subMat(par.scoringMatrixFile.aminoacids, 8.0, -0.2f);
+    const std::string db(argv[1]);
+    DBReader<unsigned int> dbr(db.c_str(), (db + ".index").c_str(), 1, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
+    dbr.open(DBReader<unsigned int>::LINEAR_ACCCESS);
+
+    Sequence seq(par.maxSeqLen, Parameters::DBTYPE_AMINO_ACIDS, &subMat, kmerSize, false, false);
+    SequenceLookup *lookup = NULL;
+    IndexTable plain(subMat.alphabetSize - 1, kmerSize, false);
+    IndexBuilder::fillDatabase(&plain, NULL, &lookup, subMat, &seq, &dbr, 0, dbr.getSize(), 0, 0, 0, false);
+    delete lookup;
+    IndexTable compressed(subMat.alphabetSize - 1, kmerSize, false);
+    IndexBuilder::fillDatabase(&compressed, NULL, &lookup, subMat, &seq, &dbr, 0, dbr.getSize(), 0, 0, 0, true);
+    delete lookup;
+
+    size_t maxListSize = 0;
+    size_t mismatches = 0;
+    for (size_t kmer = 0; kmer < plain.getTableSize(); kmer++) {
+        size_t plainSize;
+        const IndexEntryLocal *plainList = plain.getDBSeqList(kmer, &plainSize);
+        maxListSize = std::max(maxListSize, plainSize);
+        if (compressed.getDBSeqListSize(kmer) != plainSize || compressed.getDBSeqListMaxSize(kmer) < plainSize) {
+            mismatches++;
+            continue;
+        }
+        std::vector<IndexEntryLocal> decoded(plainSize);
+        compressed.copyDBSeqList(kmer, decoded.data());
+        for (size_t i = 0; i < plainSize; i++) {
+            if (decoded[i].seqId != plainList[i].seqId || decoded[i].position_j != plainList[i].position_j) {
+                mismatches++;
+                break;
+            }
+        }
+    }
+
+    const size_t plainBytes = plain.getTableEntriesNum() * sizeof(IndexEntryLocal);
+    std::cout << "entries\t" << plain.getTableEntriesNum() << std::endl;
+    std::cout << "uncompressed bytes\t" << plainBytes << std::endl;
+    std::cout << "compressed bytes\t" << compressed.getCompressedEntriesSize()
+              << " (estimated " << IndexTable::estimateCompressedEntrySize(dbr.getSize(), plain.getTableEntriesNum(), plain.getTableSize()) * plain.getTableEntriesNum() << ")" << std::endl;
+    std::cout << "ratio\t" << static_cast<double>(plainBytes) / std::max(compressed.getCompressedEntriesSize(), static_cast<size_t>(1)) << std::endl;
+    std::cout << "mismatching lists\t" << mismatches << std::endl;
+
+    IndexEntryLocal *buffer = new IndexEntryLocal[maxListSize + 1];
+    Timer timer;
+    size_t checksum = readAllLists(plain, buffer);
+    std::cout << "read uncompressed\t" << timer.getTimediff() << "\t" << checksum << std::endl;
+    timer.reset();
+    checksum = readAllLists(compressed, buffer);
+    std::cout << "read compressed\t" << timer.getTimediff() << "\t" << checksum << std::endl;
+    delete[] buffer;
+
+    dbr.close();
+    return (mismatches == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,223 @@
+// Checks that prefiltering against the copy of the index table on each NUMA node gives the same hits as the
+// single table, then measures the scaling of random index lookups from one to all NUMA nodes,
+// with one table on the first node or a copy of the table on each node
+#include <iostream>
+#include <vector>
+#include <string>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+#include "NumaTopology.h"
+#include "Prefiltering.h"
+#include "IndexBuilder.h"
+#include "ExtendedSubstitutionMatrix.h"
+#include "SubstitutionMatrix.h"
+#include "DBWriter.h"
+#include "FileUtil.h"
+#include "Timer.h"
+#include "Util.h"
+
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+const char* binary_name = "test_numascaling";
+
+size_t *allocateOnNode(const NumaTopology &topology, size_t node, size_t size) {
+    size_t *table = NULL;
+#pragma omp parallel num_threads(1)
+    {
+        topology.bindThreadToNode(node);
+        table = new size_t[size];
+        for (size_t i = 0; i < size; i++) {
+            table[i] = i * 0x9E3779B97F4A7C15ULL;
+        }
+        topology.unbindThread();
+    }
+    return table;
+}
+
+size_t lookups(const NumaTopology &topology, size_t nodes, unsigned int threads, const std::vector<size_t *> &tables,
+               size_t tableSize, size_t lookupsPerThread) {
+    size_t checksum = 0;
+#pragma omp parallel num_threads(threads) reduction(+: checksum)
+    {
+        unsigned int thread_idx = 0;
+#ifdef OPENMP
+        thread_idx = static_cast<unsigned int>(omp_get_thread_num());
+#endif
+        const size_t node = (static_cast<size_t>(thread_idx) * nodes) / threads;
+        topology.bindThreadToNode(node);
+        const size_t *table = tables[tables.size() == 1 ? 0 : node];
+        size_t state = thread_idx + 1;
+        for (size_t i = 0; i < lookupsPerThread; i++) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            checksum += table[state % tableSize];
+        }
+        topology.unbindThread();
+    }
+    return checksum;
+}
+
+size_t nextRandom(size_t &state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+// families of random protein sequences, each member differs from the family ancestor by substitutions
+std::string makeSequence(size_t family, size_t &state) {
+    const char aa[] = "ACDEFGHIKLMNPQRSTVWY";
+    size_t familyState = family + 1;
+    const size_t length = 100 + nextRandom(familyState) % 300;
+    std::string seq;
+    for (size_t i = 0; i < length; i++) {
+        const size_t letter = nextRandom(familyState) % 20;
+        seq.push_back(aa[(nextRandom(state) % 5 == 0) ? nextRandom(state) % 20 : letter]);
+    }
+    return seq;
+}
+
+std::vector<hit_t> matchQueries(IndexTable *indexTable, SequenceLookup *sequenceLookup, BaseMatrix &kmerSubMat,
+                                BaseMatrix &ungappedSubMat, ScoreMatrix &threeMer, ScoreMatrix &twoMer,
+                                DBReader<unsigned int> &tdbr, const std::vector<std::string> &queries, int kmerSize,
+                                short kmerThr) {
+    Sequence seq(tdbr.getMaxSeqLen(), Parameters::DBTYPE_AMINO_ACIDS, &kmerSubMat, kmerSize, false, true);
+    QueryMatcher matcher(indexTable, sequenceLookup, &kmerSubMat, &ungappedSubMat, kmerThr, kmerSize, tdbr.getSize(),
+                         tdbr.getMaxSeqLen(), 300, true, true, 15, false, false);
+    matcher.setSubstitutionMatrix(&threeMer, &twoMer);
+    std::vector<hit_t> hits;
+    for (size_t i = 0; i < queries.size(); i++) {
+        seq.mapSequence(i, i, queries[i].c_str(), queries[i].size());
+        std::pair<hit_t *, size_t> result = matcher.matchQuery(&seq, UINT_MAX, false);
+        hits.insert(hits.end(), result.first, result.first + result.second);
+        // separates the results of the queries
+        hit_t end = { UINT_MAX, static_cast<int>(i), 0 };
+        hits.push_back(end);
+    }
+    return hits;
+}
+
+bool sameHits(const std::vector<hit_t> &first, const std::vector<hit_t> &second) {
+    if (first.size() != second.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < first.size(); i++) {
+        if (first[i].seqId != second[i].seqId || first[i].prefScore != second[i].prefScore
+            || first[i].diagonal != second[i].diagonal) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// prefilters queries against the single index table and against each replica of it
+size_t compareReplicas(const NumaTopology &topology) {
+    const std::string db = "dataNumaReplicas";
+    std::vector<std::string> queries;
+    DBWriter writer(db.c_str(), (db + ".index").c_str(), 1, Parameters::WRITER_ASCII_MODE, Parameters::DBTYPE_AMINO_ACIDS);
+    writer.open();
+    size_t state = 42;
+    for (size_t i = 0; i < 2000; i++) {
+        const std::string seq = makeSequence(i % 200, state) + "\n";
+        writer.writeData(seq.c_str(), seq.size(), i, 0);
+        if (i % 20 == 0) {
+            queries.push_back(makeSequence(i % 200, state));
+        }
+    }
+    writer.close();
+
+    DBReader<unsigned int> tdbr(db.c_str(), (db + ".index").c_str(), 1, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
+    tdbr.open(DBReader<unsigned int>::NOSORT);
+
+    Parameters &par = Parameters::getInstance();
+    SubstitutionMatrix kmerSubMat(par.scoringMatrixFile.aminoacids, 8.0, -0.2f);
+    SubstitutionMatrix ungappedSubMat(par.scoringMatrixFile.aminoacids, 2.0, -0.2f);
+    const int kmerSize = 5;
+    const short kmerThr = Prefiltering::getKmerThreshold(5.7, false, INT_MAX, kmerSize);
+    kmerSubMat.alphabetSize = kmerSubMat.alphabetSize - 1;
+    ScoreMatrix twoMer = ExtendedSubstitutionMatrix::calcScoreMatrix(kmerSubMat, 2);
+    ScoreMatrix threeMer = ExtendedSubstitutionMatrix::calcScoreMatrix(kmerSubMat, 3);
+    kmerSubMat.alphabetSize = kmerSubMat.alphabetSize + 1;
+
+    size_t mismatches = 0;
+    for (size_t compressed = 0; compressed < 2; compressed++) {
+        Sequence tseq(tdbr.getMaxSeqLen(), Parameters::DBTYPE_AMINO_ACIDS, &kmerSubMat, kmerSize, false, true);
+        IndexTable indexTable(kmerSubMat.alphabetSize - 1, kmerSize, false);
+        SequenceLookup *sequenceLookup = NULL;
+        IndexBuilder::fillDatabase(&indexTable, NULL, &sequenceLookup, kmerSubMat, &tseq, &tdbr, 0, tdbr.getSize(),
+                                   kmerThr, false, false, compressed == 1);
+        const std::vector<hit_t> expected = matchQueries(&indexTable, sequenceLookup, kmerSubMat, ungappedSubMat,
+                                                         threeMer, twoMer, tdbr, queries, kmerSize, kmerThr);
+
+        std::vector<IndexTable *> nodeIndexTables;
+        std::vector<SequenceLookup *> nodeSequenceLookups;
+        Prefiltering::replicateIndexTable(topology, &indexTable, sequenceLookup, nodeIndexTables, nodeSequenceLookups);
+        for (size_t node = 0; node < nodeIndexTables.size(); node++) {
+            const std::vector<hit_t> hits = matchQueries(nodeIndexTables[node], nodeSequenceLookups[node], kmerSubMat,
+                                                         ungappedSubMat, threeMer, twoMer, tdbr, queries, kmerSize, kmerThr);
+            const bool same = sameHits(expected, hits);
+            std::cout << "node " << node << (compressed == 1 ? " compressed" : "") << ": " << (hits.size() - queries.size())
+                      << " hits of " << (expected.size() - queries.size()) << (same ? "" : ", results differ") << std::endl;
+            mismatches += same ? 0 : 1;
+        }
+        Prefiltering::deleteIndexReplicas(nodeIndexTables, nodeSequenceLookups);
+        delete sequenceLookup;
+    }
+
+    ExtendedSubstitutionMatrix::freeScoreMatrix(threeMer);
+    ExtendedSubstitutionMatrix::freeScoreMatrix(twoMer);
+    tdbr.close();
+    FileUtil::remove(db.c_str());
+    FileUtil::remove((db + ".index").c_str());
+    FileUtil::remove((db + ".dbtype").c_str());
+    return mismatches;
+}
+
+int main(int argc, const char **argv) {
+    NumaTopology topology;
+    if (topology.getNodeCount() == 0) {
+        std::cout << "No NUMA information found" << std::endl;
+        return EXIT_SUCCESS;
+    }
+    if (compareReplicas(topology) != 0) {
+        return EXIT_FAILURE;
+    }
+    const size_t tableSize = ((argc > 1) ? strtoull(argv[1], NULL, 10) : 1024) * 1024 * 1024 / sizeof(size_t);
+    const size_t lookupsPerThread = 20000000;
+
+    std::vector<size_t *> shared(1, allocateOnNode(topology, 0, tableSize));
+    std::vector<size_t *> replicated;
+    for (size_t node = 0; node < topology.getNodeCount(); node++) {
+        replicated.push_back(allocateOnNode(topology, node, tableSize));
+    }
+
+    std::cout << "nodes\tthreads\tshared Mlookups/s\treplicated Mlookups/s" << std::endl;
+    unsigned int threads = 0;
+    size_t checksumMismatches = 0;
+    for (size_t nodes = 1; nodes <= topology.getNodeCount(); nodes++) {
+        threads += topology.getCpus(nodes - 1).size();
+        double rates[2];
+        size_t checksums[2];
+        for (size_t mode = 0; mode < 2; mode++) {
+            std::vector<size_t *> tables(mode == 0 ? shared : replicated);
+            tables.resize(mode == 0 ? 1 : nodes);
+            Timer timer;
+            checksums[mode] = lookups(topology, nodes, threads, tables, tableSize, lookupsPerThread);
+            rates[mode] = (threads * lookupsPerThread) / (timer.getTimediff() * 1e6);
+        }
+        std::cout << nodes << "\t" << threads << "\t" << rates[0] << "\t" << rates[1]
+                  << ((checksums[0] == checksums[1]) ? "" : "\tchecksum mismatch") << std::endl;
+        checksumMismatches += (checksums[0] == checksums[1]) ? 0 : 1;
+    }
+
+    delete[] shared[0];
+    for (size_t node = 0; node < replicated.size(); node++) {
+        delete[] replicated[node];
+    }
+    return (checksumMismatches == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
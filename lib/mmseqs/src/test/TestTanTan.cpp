@@ -5,10 +5,15 @@
 #include <iostream>
 #include <cstring>
 #include <math.h>
+#include <cstdlib>
+#include <algorithm>
+#include <string>
+#include <vector>
 #include "tantan.h"
 #include "SubstitutionMatrix.h"
 #include "Sequence.h"
 #include "Parameters.h"
+#include "Timer.h"
 
 const char* binary_name = "test_tantan";
 
@@ -41,7 +46,7 @@ int main (int, const char**) {
     }
     char  refInt[100000];
 
-
+    Timer timer;
     for(size_t i = 0; i < 100000; i++){
         for(int i = 0; i < refSeq.L; i++){
             refInt[i] = (char) refSeq.numSequence[i];
@@ -59,5 +64,85 @@ int main (int, const char**) {
 
     }
     std::cout << std::endl;
-    return 0;
+    std::cout << "single sequence: " << timer.lap() << std::endl;
+
+    // six-frame fragments: many short stop-to-stop ORFs, some of them with short-period repeats
+    ProbabilityMatrix fragmentProbMatrix(subMat);
+    const size_t fragmentCount = 200000;
+    std::vector<std::string> fragments(fragmentCount);
+    unsigned int state = 1;
+    size_t residues = 0;
+    for (size_t i = 0; i < fragmentCount; ++i) {
+        state = state * 1103515245 + 12345;
+        size_t fragmentLen = 15 + (state >> 16) % 150;
+        size_t period = (i % 7 == 0) ? (1 + (state >> 8) % 12) : 0;
+        for (size_t pos = 0; pos < fragmentLen; ++pos) {
+            state = state * 1103515245 + 12345;
+            if (period > 0 && pos >= period && (state >> 16) % 10 != 0) {
+                fragments[i].push_back(fragments[i][pos - period]);
+            } else {
+                fragments[i].push_back((char) ((state >> 16) % 20));
+            }
+        }
+        residues += fragmentLen;
+    }
+
+    timer.reset();
+    size_t masked = 0;
+    size_t checksum = 0;
+    for (size_t i = 0; i < fragmentCount; ++i) {
+        char *seq = &fragments[i][0];
+        masked += tantan::maskSequences(seq, seq + fragments[i].size(), 50 /*options.maxCycleLength*/,
+                                        fragmentProbMatrix.probMatrixPointers,
+                                        0.005 /*options.repeatProb*/, 0.05 /*options.repeatEndProb*/,
+                                        0.9 /*options.repeatOffsetProbDecay*/,
+                                        0, 0,
+                                        0.9 /*options.minMaskProb*/, fragmentProbMatrix.hardMaskTable);
+        for (size_t pos = 0; pos < fragments[i].size(); ++pos) {
+            checksum = checksum * 31 + (unsigned char) seq[pos];
+        }
+    }
+    std::cout << "fragments: " << timer.lap() << " (" << fragmentCount << " fragments, " << residues << " residues, "
+              << masked << " masked, checksum " << checksum << ")" << std::endl;
+
+    // the vectorized sums over the offsets are reassociated, compare them with the scalar ones on repeat-rich sequences
+    // of lengths around the SIMD width, the maximal offset and the emission block size
+    const size_t lengths[] = { 3, 5, 49, 50, 51, 200, 1023, 1024, 1025, 1075, 3000 };
+    double maxDifference = 0;
+    size_t maskMismatches = 0;
+    size_t compared = 0;
+    for (size_t lenIdx = 0; lenIdx < sizeof(lengths) / sizeof(lengths[0]); ++lenIdx) {
+        for (size_t period = 1; period <= 12; ++period) {
+            std::string seq;
+            for (size_t pos = 0; pos < lengths[lenIdx]; ++pos) {
+                state = state * 1103515245 + 12345;
+                // repeats interrupted by random stretches and substitutions
+                bool inRepeat = (pos / 100) % 3 != 2;
+                if (inRepeat && pos >= period && (state >> 16) % 10 != 0) {
+                    seq.push_back(seq[pos - period]);
+                } else {
+                    seq.push_back((char) ((state >> 16) % 20));
+                }
+            }
+            std::vector<float> vectorized(seq.size());
+            std::vector<float> scalar(seq.size());
+            tantan::getProbabilities(seq.data(), seq.data() + seq.size(), 50, fragmentProbMatrix.probMatrixPointers,
+                                     0.005, 0.05, 0.9, 0, 0, vectorized.data(), true);
+            tantan::getProbabilities(seq.data(), seq.data() + seq.size(), 50, fragmentProbMatrix.probMatrixPointers,
+                                     0.005, 0.05, 0.9, 0, 0, scalar.data(), false);
+            for (size_t pos = 0; pos < seq.size(); ++pos) {
+                maxDifference = std::max(maxDifference, (double) std::abs(vectorized[pos] - scalar[pos]));
+                maskMismatches += ((vectorized[pos] >= 0.5) != (scalar[pos] >= 0.5)) ? 1 : 0;
+                maskMismatches += ((vectorized[pos] >= 0.9) != (scalar[pos] >= 0.9)) ? 1 : 0;
+            }
+            compared += seq.size();
+        }
+    }
+    std::cout << "vectorized vs scalar: " << compared << " residues, max probability difference " << maxDifference
+              << ", " << maskMismatches << " mask mismatches" << std::endl;
+    if (maxDifference > 1e-5 || maskMismatches > 0) {
+        std::cout << "vectorized probabilities differ from the scalar ones" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
 }
@@ -143,7 +143,7 @@ int convertprofiledb(int argc, const char **argv, const Command &command) {
     DBWriter profileWriter(par.db2.c_str(), par.db2Index.c_str(), par.threads, par.compressed, Parameters::DBTYPE_HMM_PROFILE);
     profileWriter.open();
 
-    DBWriter headerWriter(par.hdr2.c_str(), par.hdr2Index.c_str(), par.threads, par.compressed, Parameters::DBTYPE_GENERIC_DB);
+    DBWriter headerWriter(par.hdr2.c_str(), par.hdr2Index.c_str(), par.threads, Parameters::withoutDictionary(par.compressed), Parameters::DBTYPE_GENERIC_DB);
     headerWriter.open();
 
     SubstitutionMatrix subMat(par.scoringMatrixFile.aminoacids, 2.0, 0.0);
@@ -12,6 +12,178 @@
 #include "KSeqWrapper.h"
 #include "itoa.h"
 
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef HAVE_BZLIB
+#include <bzlib.h>
+#endif
+
+// reads plain, gzip or bzip2 compressed fasta files in blocks of complete records
+class FastaBlockReader {
+public:
+    FastaBlockReader(const char *fileName) : file(NULL), eof(false) {
+#ifdef HAVE_ZLIB
+        gzInput = NULL;
+#endif
+#ifdef HAVE_BZLIB
+        bzInput = NULL;
+#endif
+        if (Util::endsWith(".gz", fileName)) {
+#ifdef HAVE_ZLIB
+            gzInput = gzopen(fileName, "r");
+            if (gzInput == NULL) {
+                perror(fileName);
+                EXIT(EXIT_FAILURE);
+            }
+#else
+            Debug(Debug::ERROR) << "MMseqs was not compiled with zlib support. Can not read compressed input!\n";
+            EXIT(EXIT_FAILURE);
+#endif
+        } else if (Util::endsWith(".bz2", fileName)) {
+#ifdef HAVE_BZLIB
+            file = FileUtil::openFileOrDie(fileName, "r+b", true);
+            int bzError;
+            bzInput = BZ2_bzReadOpen(&bzError, file, 0, 0, NULL, 0);
+            if (bzError != 0) {
+                perror(fileName);
+                EXIT(EXIT_FAILURE);
+            }
+#else
+            Debug(Debug::ERROR) << "MMseqs was not compiled with bz2lib support. Can not read compressed input!\n";
+            EXIT(EXIT_FAILURE);
+#endif
+        } else {
+            file = FileUtil::openFileOrDie(fileName, "r", true);
+        }
+    }
+
+    ~FastaBlockReader() {
+#ifdef HAVE_ZLIB
+        if (gzInput != NULL) {
+            gzclose(gzInput);
+        }
+#endif
+#ifdef HAVE_BZLIB
+        if (bzInput != NULL) {
+            int bzError;
+            BZ2_bzReadClose(&bzError, bzInput);
+        }
+#endif
+        if (file != NULL && fclose(file) != 0) {
+            Debug(Debug::ERROR) << "Cannot close fasta input file\n";
+            EXIT(EXIT_FAILURE);
+        }
+    }
+
+    // the format can only be decided on the first bytes, fastq quality lines may start with '@'
+    bool isFasta() {
+        if (rest.empty() && eof == false) {
+            rest.resize(4096);
+            rest.resize(read(&rest[0], rest.size()));
+            eof = rest.empty();
+        }
+        for (size_t i = 0; i < rest.size(); i++) {
+            if (isspace(static_cast<unsigned char>(rest[i])) == false) {
+                return rest[i] == '>';
+            }
+        }
+        return false;
+    }
+
+    // fills block with at least blockSize bytes of complete records
+    // the partial last record is kept for the next call, returns false at the end of the input
+    bool nextBlock(std::string &block, size_t blockSize) {
+        block.swap(rest);
+        rest.clear();
+        while (eof == false) {
+            const size_t start = block.size();
+            block.resize(start + blockSize);
+            const size_t readBytes = read(&block[start], blockSize);
+            block.resize(start + readBytes);
+            if (readBytes == 0) {
+                eof = true;
+                break;
+            }
+            // a record starts after the last newline followed by a '>'
+            for (size_t pos = block.size() - 1; pos > 0 && pos + 1 > start; pos--) {
+                if (block[pos] == '>' && block[pos - 1] == '\n') {
+                    rest.assign(block, pos, std::string::npos);
+                    block.resize(pos);
+                    return true;
+                }
+            }
+        }
+        return block.empty() == false;
+    }
+
+private:
+    size_t read(char *buffer, size_t size) {
+#ifdef HAVE_ZLIB
+        if (gzInput != NULL) {
+            int readBytes = gzread(gzInput, buffer, size);
+            if (readBytes < 0) {
+                Debug(Debug::ERROR) << "Cannot read compressed fasta input\n";
+                EXIT(EXIT_FAILURE);
+            }
+            return readBytes;
+        }
+#endif
+#ifdef HAVE_BZLIB
+        if (bzInput != NULL) {
+            int readBytes = BZ2_bzread(bzInput, buffer, size);
+            if (readBytes < 0) {
+                Debug(Debug::ERROR) << "Cannot read compressed fasta input\n";
+                EXIT(EXIT_FAILURE);
+            }
+            return readBytes;
+        }
+#endif
+        return fread(buffer, sizeof(char), size, file);
+    }
+
+    FILE *file;
+#ifdef HAVE_ZLIB
+    gzFile gzInput;
+#endif
+#ifdef HAVE_BZLIB
+    BZFILE *bzInput;
+#endif
+    std::string rest;
+    bool eof;
+};
+
+// fasta records of a part of a block, headers and sequences are stored with their terminating newline
+struct FastaChunk {
+    std::string headers;
+    std::string sequences;
+    std::vector<size_t> headerEnd;
+    std::vector<size_t> sequenceEnd;
+};
+
+static bool isNucleotideSequence(const char *sequence, size_t length) {
+    size_t cnt = 0;
+    for (size_t i = 0; i < length; i++) {
+        switch (toupper(sequence[i])) {
+            case 'T':
+            case 'A':
+            case 'G':
+            case 'C':
+            case 'U':
+            case 'N':
+                cnt++;
+                break;
+        }
+    }
+    const float nuclDNAFraction = static_cast<float>(cnt) / static_cast<float>(length);
+    return nuclDNAFraction > 0.9;
+}
+
 int createdb(int argc, const char **argv, const Command& command) {
     Parameters &par = Parameters::getInstance();
     par.parseParameters(argc, argv, command, true, Parameters::PARSE_VARIADIC, 0);
@@ -84,14 +256,17 @@ int createdb(int argc, const char **argv, const Command& command) {
     std::string sourceFile = dataFile + ".source";
 
     redoComputation:
+    entries_num = 0;
+    sampleCount = 0;
+    isNuclCnt = 0;
     FILE *source = fopen(sourceFile.c_str(), "w");
     if (source == NULL) {
         Debug(Debug::ERROR) << "Cannot open " << sourceFile << " for writing\n";
         EXIT(EXIT_FAILURE);
     }
-    DBWriter hdrWriter(hdrDataFile.c_str(), hdrIndexFile.c_str(), shuffleSplits, par.compressed, Parameters::DBTYPE_GENERIC_DB);
+    DBWriter hdrWriter(hdrDataFile.c_str(), hdrIndexFile.c_str(), shuffleSplits, Parameters::withoutDictionary(par.compressed), Parameters::DBTYPE_GENERIC_DB);
     hdrWriter.open();
-    DBWriter seqWriter(dataFile.c_str(), indexFile.c_str(), shuffleSplits, par.compressed, (dbType == -1) ? Parameters::DBTYPE_OMIT_FILE : dbType );
+    DBWriter seqWriter(dataFile.c_str(), indexFile.c_str(), shuffleSplits, Parameters::withoutDictionary(par.compressed), (dbType == -1) ? Parameters::DBTYPE_OMIT_FILE : dbType );
     seqWriter.open();
     size_t headerFileOffset = 0;
     size_t seqFileOffset = 0;
@@ -125,6 +300,113 @@ int createdb(int argc, const char **argv, const Command& command) {
             EXIT(EXIT_FAILURE);
         }
 
+        // fasta files are parsed in parallel, in blocks of complete records
+        // the records of a block are numbered in input order, so the keys do not depend on the number of threads
+        if (dbInput == false && par.createdbMode == Parameters::SEQUENCE_SPLIT_MODE_HARD && par.threads > 1 && filenames[fileIdx] != "stdin") {
+            FastaBlockReader blockReader(filenames[fileIdx].c_str());
+            if (blockReader.isFasta()) {
+                const size_t blockSize = static_cast<size_t>(par.threads) * 8 * 1024 * 1024;
+                std::string block;
+                std::vector<FastaChunk> chunks(par.threads);
+                std::vector<size_t> chunkBounds(par.threads + 1);
+                std::vector<size_t> chunkFirstEntry(par.threads + 1);
+                while (blockReader.nextBlock(block, blockSize)) {
+                    // cut the block into one chunk per thread at record starts
+                    chunkBounds[0] = 0;
+                    for (int i = 1; i < par.threads; i++) {
+                        size_t pos = std::max(chunkBounds[i - 1], block.size() / par.threads * i);
+                        while (pos < block.size() && (pos == 0 || block[pos] != '>' || block[pos - 1] != '\n')) {
+                            pos++;
+                        }
+                        chunkBounds[i] = pos;
+                    }
+                    chunkBounds[par.threads] = block.size();
+
+#pragma omp parallel for schedule(static, 1) num_threads(par.threads)
+                    for (int i = 0; i < par.threads; i++) {
+                        FastaChunk &chunk = chunks[i];
+                        chunk.headers.clear();
+                        chunk.sequences.clear();
+                        chunk.headerEnd.clear();
+                        chunk.sequenceEnd.clear();
+                        if (chunkBounds[i] == chunkBounds[i + 1]) {
+                            continue;
+                        }
+                        KSeqBuffer kseqChunk(block.c_str() + chunkBounds[i], chunkBounds[i + 1] - chunkBounds[i]);
+                        while (kseqChunk.ReadEntry()) {
+                            const KSeqWrapper::KSeqEntry &e = kseqChunk.entry;
+                            chunk.headers.append(e.name.s, e.name.l);
+                            if (e.comment.l > 0) {
+                                chunk.headers.append(" ", 1);
+                                chunk.headers.append(e.comment.s, e.comment.l);
+                            }
+                            chunk.headers.push_back('\n');
+                            chunk.headerEnd.emplace_back(chunk.headers.size());
+                            chunk.sequences.append(e.sequence.s, e.sequence.l);
+                            chunk.sequences.push_back(newline);
+                            chunk.sequenceEnd.emplace_back(chunk.sequences.size());
+                        }
+                    }
+
+                    size_t blockEntries = 0;
+                    for (int i = 0; i < par.threads; i++) {
+                        chunkFirstEntry[i] = blockEntries;
+                        blockEntries += chunks[i].headerEnd.size();
+                    }
+                    chunkFirstEntry[par.threads] = blockEntries;
+
+                    // checks that depend on the input order
+                    for (int i = 0; i < par.threads; i++) {
+                        const FastaChunk &chunk = chunks[i];
+                        for (size_t j = 0; j < chunk.headerEnd.size(); j++) {
+                            const size_t entry = entries_num + chunkFirstEntry[i] + j;
+                            const size_t headerStart = (j == 0) ? 0 : chunk.headerEnd[j - 1];
+                            if (chunk.headers[headerStart] == ' ' || chunk.headers[headerStart] == '\n') {
+                                Debug(Debug::ERROR) << "Fasta entry " << entry << " is invalid\n";
+                                EXIT(EXIT_FAILURE);
+                            }
+                            if (dbType == -1 && (sampleCount < 10 || (sampleCount % 100) == 0)) {
+                                if (sampleCount < testForNucSequence) {
+                                    const size_t sequenceStart = (j == 0) ? 0 : chunk.sequenceEnd[j - 1];
+                                    isNuclCnt += isNucleotideSequence(chunk.sequences.c_str() + sequenceStart, chunk.sequenceEnd[j] - sequenceStart - 1);
+                                }
+                                sampleCount++;
+                            }
+                            unsigned int id = par.identifierOffset + entry;
+                            sourceLookup[id % shuffleSplits].emplace_back(fileIdx);
+                        }
+                    }
+
+                    // every shuffle split is written by one thread in input order
+#pragma omp parallel for schedule(dynamic, 1) num_threads(par.threads)
+                    for (unsigned int splitIdx = 0; splitIdx < shuffleSplits; splitIdx++) {
+                        for (int i = 0; i < par.threads; i++) {
+                            const FastaChunk &chunk = chunks[i];
+                            for (size_t j = 0; j < chunk.headerEnd.size(); j++) {
+                                const size_t entry = entries_num + chunkFirstEntry[i] + j;
+                                unsigned int id = par.identifierOffset + entry;
+                                if (id % shuffleSplits != splitIdx) {
+                                    continue;
+                                }
+                                progress.updateProgress();
+                                const size_t headerStart = (j == 0) ? 0 : chunk.headerEnd[j - 1];
+                                const char *header = chunk.headers.c_str() + headerStart;
+                                if (Util::parseFastaHeader(header).empty()) {
+                                    Debug(Debug::WARNING) << "Cannot extract identifier from entry " << entry << "\n";
+                                }
+                                hdrWriter.writeData(header, chunk.headerEnd[j] - headerStart, id, splitIdx);
+                                const size_t sequenceStart = (j == 0) ? 0 : chunk.sequenceEnd[j - 1];
+                                seqWriter.writeData(chunk.sequences.c_str() + sequenceStart, chunk.sequenceEnd[j] - sequenceStart, id, splitIdx);
+                            }
+                        }
+                    }
+                    entries_num += blockEntries;
+                    numEntriesInCurrFile += blockEntries;
+                }
+                continue;
+            }
+        }
+
         KSeqWrapper* kseq = NULL;
         if (dbInput == true) {
             kseq = new KSeqBuffer(reader->getData(fileIdx, 0), reader->getEntryLen(fileIdx) - 1);
@@ -176,43 +458,28 @@ int createdb(int argc, const char **argv, const Command& command) {
                 // check for the first 10 sequences if they are nucleotide sequences
                 if (sampleCount < 10 || (sampleCount % 100) == 0) {
                     if (sampleCount < testForNucSequence) {
-                        size_t cnt = 0;
-                        for (size_t i = 0; i < e.sequence.l; i++) {
-                            switch (toupper(e.sequence.s[i])) {
-                                case 'T':
-                                case 'A':
-                                case 'G':
-                                case 'C':
-                                case 'U':
-                                case 'N':
-                                    cnt++;
-                                    break;
-                            }
-                        }
-                        const float nuclDNAFraction = static_cast<float>(cnt) / static_cast<float>(e.sequence.l);
-                        if (nuclDNAFraction > 0.9) {
-                            isNuclCnt += true;
-                        }
+                        isNuclCnt += isNucleotideSequence(e.sequence.s, e.sequence.l);
                     }
                     sampleCount++;
                 }
-                if (par.createdbMode == Parameters::SEQUENCE_SPLIT_MODE_SOFT && e.multiline == true) {
-                    Debug(Debug::WARNING) << "Multiline fasta can not be combined with --createdb-mode 0\n";
-                    Debug(Debug::WARNING) << "We recompute with --createdb-mode 1\n";
-                    par.createdbMode = Parameters::SEQUENCE_SPLIT_MODE_HARD;
-                    progress.reset(SIZE_MAX);
-                    hdrWriter.close();
-                    seqWriter.close();
-                    delete kseq;
-                    if (fclose(source) != 0) {
-                        Debug(Debug::ERROR) << "Cannot close file " << sourceFile << "\n";
-                        EXIT(EXIT_FAILURE);
-                    }
-                    for (size_t i = 0; i < shuffleSplits; ++i) {
-                        sourceLookup[i].clear();
-                    }
-                    goto redoComputation;
+            }
+            // the index of a soft linked database can only point to sequences on a single line
+            if (par.createdbMode == Parameters::SEQUENCE_SPLIT_MODE_SOFT && e.multiline == true) {
+                Debug(Debug::WARNING) << "Multiline fasta can not be combined with --createdb-mode 0\n";
+                Debug(Debug::WARNING) << "We recompute with --createdb-mode 1\n";
+                par.createdbMode = Parameters::SEQUENCE_SPLIT_MODE_HARD;
+                progress.reset(SIZE_MAX);
+                hdrWriter.close();
+                seqWriter.close();
+                delete kseq;
+                if (fclose(source) != 0) {
+                    Debug(Debug::ERROR) << "Cannot close file " << sourceFile << "\n";
+                    EXIT(EXIT_FAILURE);
+                }
+                for (size_t i = 0; i < shuffleSplits; ++i) {
+                    sourceLookup[i].clear();
                 }
+                goto redoComputation;
             }
 
             // Finally write down the entry
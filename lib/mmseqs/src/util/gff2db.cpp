@@ -23,7 +23,7 @@ int gff2db(int argc, const char **argv, const Command &command) {
 
     DBWriter writer(par.db3.c_str(), par.db3Index.c_str(), 1, par.compressed, Parameters::DBTYPE_NUCLEOTIDES);
     writer.open();
-    DBWriter headerWriter(par.hdr3.c_str(), par.hdr3Index.c_str(), 1, par.compressed, Parameters::DBTYPE_GENERIC_DB);
+    DBWriter headerWriter(par.hdr3.c_str(), par.hdr3Index.c_str(), 1, Parameters::withoutDictionary(par.compressed), Parameters::DBTYPE_GENERIC_DB);
     headerWriter.open();
 
     bool shouldCompareType = par.gffType.length() > 0;
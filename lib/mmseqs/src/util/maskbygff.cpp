@@ -88,7 +88,7 @@ int maskbygff(int argc, const char **argv, const Command& command) {
     DBReader<std::string> headerReader(par.hdr2.c_str(), par.hdr2Index.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
     headerReader.open(DBReader<std::string>::NOSORT);
 
-    DBWriter headerWriter(par.hdr3.c_str(), par.hdr3Index.c_str(), 1, par.compressed, Parameters::DBTYPE_GENERIC_DB);
+    DBWriter headerWriter(par.hdr3.c_str(), par.hdr3Index.c_str(), 1, Parameters::withoutDictionary(par.compressed), Parameters::DBTYPE_GENERIC_DB);
     headerWriter.open();
 
     for(size_t i = 0; i < reader.getSize(); ++i ) {
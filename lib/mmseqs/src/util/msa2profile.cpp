@@ -116,7 +116,7 @@ int msa2profile(int argc, const char **argv, const Command &command) {
     DBWriter resultWriter(par.db2.c_str(), par.db2Index.c_str(), threads, par.compressed, Parameters::DBTYPE_HMM_PROFILE);
     resultWriter.open();
 
-    DBWriter headerWriter(par.hdr2.c_str(), par.hdr2Index.c_str(), threads, par.compressed, Parameters::DBTYPE_GENERIC_DB);
+    DBWriter headerWriter(par.hdr2.c_str(), par.hdr2Index.c_str(), threads, Parameters::withoutDictionary(par.compressed), Parameters::DBTYPE_GENERIC_DB);
     headerWriter.open();
 
     SubstitutionMatrix subMat(par.scoringMatrixFile.aminoacids, 2.0f, -0.2f);
@@ -126,7 +126,7 @@ int msa2result(int argc, const char **argv, const Command &command) {
     DBWriter sequenceWriter(par.db2.c_str(), par.db2Index.c_str(), threads, par.compressed, Parameters::DBTYPE_AMINO_ACIDS);
     sequenceWriter.open();
 
-    DBWriter headerWriter(par.hdr2.c_str(), par.hdr2Index.c_str(), threads, par.compressed, Parameters::DBTYPE_GENERIC_DB);
+    DBWriter headerWriter(par.hdr2.c_str(), par.hdr2Index.c_str(), threads, Parameters::withoutDictionary(par.compressed), Parameters::DBTYPE_GENERIC_DB);
     headerWriter.open();
 
     DBWriter resultWriter(par.db3.c_str(), par.db3Index.c_str(), threads, par.compressed, Parameters::DBTYPE_ALIGNMENT_RES);
@@ -135,8 +135,11 @@ int renamedbkeys(int argc, const char **argv, const Command &command) {
     // merge any kind of sequence database
     writer.close(headerWriter != NULL);
     DBWriter::writeDbtypeFile(par.db3.c_str(), reader.getDbtype(), isCompressed);
+    // compressed entries are copied verbatim and still need their dictionary
     if (par.subDbMode == Parameters::SUBDB_MODE_SOFT) {
-        DBReader<unsigned int>::softlinkDb(par.db2, par.db3, DBFiles::DATA);
+        DBReader<unsigned int>::softlinkDb(par.db2, par.db3, (DBFiles::Files) (DBFiles::DATA | DBFiles::DATA_DICT));
+    } else {
+        DBReader<unsigned int>::copyDb(par.db2, par.db3, DBFiles::DATA_DICT);
     }
     if (newMappingFile != NULL) {
         SORT_PARALLEL(newMapping.begin(), newMapping.end(), compareToFirst);
@@ -169,7 +172,9 @@ int renamedbkeys(int argc, const char **argv, const Command &command) {
         delete headerWriter;
         DBWriter::writeDbtypeFile(par.hdr3.c_str(), headerReader->getDbtype(), isHeaderCompressed);
         if (par.subDbMode == Parameters::SUBDB_MODE_SOFT) {
-            DBReader<unsigned int>::softlinkDb(par.db2, par.db3, DBFiles::HEADER);
+            DBReader<unsigned int>::softlinkDb(par.db2, par.db3, (DBFiles::Files) (DBFiles::HEADER | DBFiles::HEADER_DICT));
+        } else {
+            DBReader<unsigned int>::copyDb(par.db2, par.db3, DBFiles::HEADER_DICT);
         }
     }
     if (par.subDbMode == Parameters::SUBDB_MODE_SOFT) {
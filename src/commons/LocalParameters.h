@@ -24,6 +24,7 @@ public:
     std::vector<MMseqsParameter*> collectoptimalset;
     std::vector<MMseqsParameter*> reduceredundancy;
     std::vector<MMseqsParameter*> unitesetstofasta;
+    std::vector<MMseqsParameter*> filternoncoding;
 
     PARAMETER(PARAM_REVERSE_FRAGMENTS)
     int reverseFragments;
@@ -64,6 +65,21 @@ public:
     PARAMETER(PARAM_WRITE_FRAG_COORDS)
     int writeFragCoords;
 
+    PARAMETER(PARAM_CREATE_TARGET_INDEX)
+    int createTargetIndex;
+
+    PARAMETER(PARAM_TARGET_DB_PATH)
+    std::string targetDbPath;
+
+    PARAMETER(PARAM_FAST_PASS_SENS)
+    float fastPassSensitivity;
+
+    PARAMETER(PARAM_FILTER_NONCODING)
+    int filterNoncoding;
+
+    PARAMETER(PARAM_MIN_CODING_SCORE)
+    float minCodingScore;
+
 private:
     LocalParameters() : 
         Parameters(),
@@ -79,7 +95,12 @@ private:
         PARAM_SHOULD_TRANSLATE(PARAM_SHOULD_TRANSLATE_ID,"--protein", "translate codons to AAs", "translate the joint exons coding sequence to amino acids [0,1]", typeid(int), (void *) &shouldTranslate, "^[0-1]{1}$"),
         PARAM_ALLOW_OVERLAP(PARAM_ALLOW_OVERLAP_ID,"--overlap", "allow same-strand overlaps", "allow predictions to overlap another on the same strand. when not allowed (default), only the prediction with better E-value will be retained [0,1]", typeid(int), (void *) &overlapAllowed, "^[0-1]{1}$"),
         PARAM_WRITE_TKEY(PARAM_WRITE_TKEY_ID,"--target-key", "write target key instead of accession", "write the target key (internal DB identifier) instead of its accession. By default (0) target accession will be written [0,1]", typeid(int), (void *) &writeTargetKey, "^[0-1]{1}$"),
-        PARAM_WRITE_FRAG_COORDS(PARAM_WRITE_FRAG_COORDS_ID,"--write-frag-coords", "write fragment contig coords", "write the contig coords of the stop-to-stop fragment in which putative exon lies. By default (0) only putative exon coords will be written [0,1]", typeid(int), (void *) &writeFragCoords, "^[0-1]{1}$")
+        PARAM_WRITE_FRAG_COORDS(PARAM_WRITE_FRAG_COORDS_ID,"--write-frag-coords", "write fragment contig coords", "write the contig coords of the stop-to-stop fragment in which putative exon lies. By default (0) only putative exon coords will be written [0,1]", typeid(int), (void *) &writeFragCoords, "^[0-1]{1}$"),
+        PARAM_CREATE_TARGET_INDEX(PARAM_CREATE_TARGET_INDEX_ID,"--create-target-index", "create a prefilter index for the targets", "build the prefilter index targetsDB.idx if it does not exist yet or does not match the search parameters, so that later runs against the same targets map it instead of recomputing it. By default (0) an existing index is used but none is created [0,1]", typeid(int), (void *) &createTargetIndex, "^[0-1]{1}$"),
+        PARAM_TARGET_DB_PATH(PARAM_TARGET_DB_PATH_ID,"--target-db-path", "path of the target database built from fasta", "with --create-target-index 1 and fasta targets, easy-predict keeps the target database and its index at this path and reuses them in later runs. By default they are written next to the fasta file as <targets>_db", typeid(std::string), (void *) &targetDbPath, ""),
+        PARAM_FAST_PASS_SENS(PARAM_FAST_PASS_SENS_ID,"--fast-pass-sens", "Sensitivity of a fast first search pass", "search all fragments with this sensitivity first, only fragments that are not part of an optimal exon set but overlap one or lie at most --max-intron away from it are searched again with -s. By default (0) all fragments are searched once with -s", typeid(float), (void *) &fastPassSensitivity, "^[0-9]*(\\.[0-9]+)?$"),
+        PARAM_FILTER_NONCODING(PARAM_FILTER_NONCODING_ID,"--filter-noncoding", "remove noncoding fragments before the search", "score the fragments with a dipeptide model of the targets and only search fragments with a coding score of at least --min-coding-score. By default (0) all fragments are searched [0,1]", typeid(int), (void *) &filterNoncoding, "^[0-1]{1}$"),
+        PARAM_MIN_CODING_SCORE(PARAM_MIN_CODING_SCORE_ID,"--min-coding-score", "Minimal coding score of a fragment", "minimal dipeptide log-odds score (in bits) of the best segment of a fragment, of the targets against all fragments, for the fragment to be searched", typeid(float), (void *) &minCodingScore, "^-?[0-9]*(\\.[0-9]+)?$")
     {
         collectoptimalset.push_back(&PARAM_METAEUK_EVAL_THR);
         collectoptimalset.push_back(&PARAM_METAEUK_TARGET_COV_THR);
@@ -97,6 +118,15 @@ private:
         // predictexonsworkflow = combineList(extractorfs, translatenucs); // available through searchworkflow
         predictexonsworkflow = combineList(searchworkflow, collectoptimalset);
         predictexonsworkflow.push_back(&PARAM_REVERSE_FRAGMENTS);
+        predictexonsworkflow.push_back(&PARAM_CREATE_TARGET_INDEX);
+        predictexonsworkflow.push_back(&PARAM_FAST_PASS_SENS);
+        predictexonsworkflow.push_back(&PARAM_FILTER_NONCODING);
+        predictexonsworkflow.push_back(&PARAM_MIN_CODING_SCORE);
+
+        filternoncoding.push_back(&PARAM_MIN_CODING_SCORE);
+        filternoncoding.push_back(&PARAM_THREADS);
+        filternoncoding.push_back(&PARAM_COMPRESSED);
+        filternoncoding.push_back(&PARAM_V);
 
         reduceredundancy.push_back(&PARAM_ALLOW_OVERLAP);
         reduceredundancy.push_back(&PARAM_THREADS);
@@ -115,6 +145,12 @@ private:
         easypredictworkflow = combineList(easypredictworkflow, reduceredundancy);
         easypredictworkflow = combineList(easypredictworkflow, unitesetstofasta);
         easypredictworkflow.push_back(&PARAM_REVERSE_FRAGMENTS);
+        easypredictworkflow.push_back(&PARAM_CREATE_TARGET_INDEX);
+        easypredictworkflow.push_back(&PARAM_TARGET_DB_PATH);
+        easypredictworkflow.push_back(&PARAM_FAST_PASS_SENS);
+        easypredictworkflow.push_back(&PARAM_FILTER_NONCODING);
+        easypredictworkflow.push_back(&PARAM_MIN_CODING_SCORE);
+        easypredictworkflow.push_back(&PARAM_CREATEDB_MODE);
 
         taxpercontigworkflow = combineList(taxonomy, aggregatetax);
         
@@ -143,6 +179,17 @@ private:
         // default value 0 means only coords of putative exon are written
         writeFragCoords = 0;
 
+        // default value 0 means an existing target index is used, but none is created
+        createTargetIndex = 0;
+        targetDbPath = "";
+
+        // default value 0 means a single search pass with the full sensitivity
+        fastPassSensitivity = 0;
+
+        // default value 0 means all fragments are searched
+        filterNoncoding = 0;
+        minCodingScore = 10;
+
         citations.emplace(CITATION_METAEUK, "Levy Karin E, Mirdita M, Soeding J: MetaEuk – sensitive, high-throughput gene discovery and annotation for large-scale eukaryotic metagenomics. biorxiv, 851964 (2019).");
     }
     LocalParameters(LocalParameters const&);
@@ -6,8 +6,10 @@
 #include "MathUtil.h"
 #include "itoa.h"
 #include "PredictionParser.h"
+#include "simd.h"
 
 #include <limits>
+#include <climits>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -105,9 +107,32 @@ int getPenaltyForProtCoords(const PotentialExon & prevPotentialExon, const Poten
     return -1000;
 }
 
+// coordinates of the sorted candidates as a structure of arrays, so that the compatibility
+// of VECSIZE_INT predecessors with the current candidate can be evaluated at once
+struct PotentialExonCoords {
+    void reset(size_t numCandidates) {
+        // pad to full vectors, the padding is never read as a predecessor
+        size_t paddedSize = numCandidates + VECSIZE_INT;
+        strand.resize(paddedSize);
+        contigStart.resize(paddedSize);
+        contigEnd.resize(paddedSize);
+        targetMatchStart.resize(paddedSize);
+        targetMatchEnd.resize(paddedSize);
+        pathScoreWithBonus.resize(paddedSize);
+    }
+
+    std::vector<int> strand;
+    std::vector<int> contigStart;
+    std::vector<int> contigEnd;
+    std::vector<int> targetMatchStart;
+    std::vector<int> targetMatchEnd;
+    // best path score ending in this row, plus the bonus for extending that path by one exon
+    std::vector<int> pathScoreWithBonus;
+};
+
 int findoptimalsetbydp(std::vector<PotentialExon> & potentialExonCandidates, std::vector<PotentialExon> & optimalExonSet, 
-                        const size_t minIntronLength, const size_t maxIntronLength, const size_t maxAaOvelap, const int setGapOpenPenalty, 
-                        const int setGapExtendPenalty, const double dMetaeukTargetCovThr) {
+                        PotentialExonCoords & coords, const size_t minIntronLength, const size_t maxIntronLength, const size_t maxAaOvelap,
+                        const int setGapOpenPenalty, const int setGapExtendPenalty, const double dMetaeukTargetCovThr) {
     size_t numPotentialExonCandidates = potentialExonCandidates.size();
     if (numPotentialExonCandidates == 0) {
         // nothing to do here!
@@ -132,11 +157,17 @@ int findoptimalsetbydp(std::vector<PotentialExon> & potentialExonCandidates, std
     }
     std::vector<dpMatrixRow> prevIdsAndScoresBestPath;
     prevIdsAndScoresBestPath.reserve(numPotentialExonCandidates);
+    coords.reset(numPotentialExonCandidates);
     // initialize:
     for (size_t id = 0; id < numPotentialExonCandidates; ++id) {
         prevIdsAndScoresBestPath.emplace_back(dpMatrixRow(id, potentialExonCandidates[id].bitScore, 1, 
                                               potentialExonCandidates[id].targetCov, potentialExonCandidates[id].aaLen));
-        
+        coords.strand[id] = potentialExonCandidates[id].strand;
+        coords.contigStart[id] = potentialExonCandidates[id].contigStart;
+        coords.contigEnd[id] = potentialExonCandidates[id].contigEnd;
+        coords.targetMatchStart[id] = potentialExonCandidates[id].targetMatchStart;
+        coords.targetMatchEnd[id] = potentialExonCandidates[id].targetMatchEnd;
+
         // sanity check - all exons refer to the same target
         if (potentialExonCandidates[id].targetLen != targetLength) {
             Debug(Debug::ERROR) << "two exons are analyzed in the context of differnt targets.\n";
@@ -144,45 +175,138 @@ int findoptimalsetbydp(std::vector<PotentialExon> & potentialExonCandidates, std
         }
     }
 
+    // limits of isPairCompatible as int, so they can be compared in vector lanes
+    const int minIntron = static_cast<int>(std::min(minIntronLength, static_cast<size_t>(INT_MAX)));
+    const int maxIntron = static_cast<int>(std::min(maxIntronLength, static_cast<size_t>(INT_MAX)));
+    const int maxOverlap = static_cast<int>(std::min(maxAaOvelap, static_cast<size_t>(INT_MAX)));
+
+    const simd_int vOne = simdi32_set(1);
+    const simd_int vZero = simdi_setzero();
+    const simd_int vIncompatible = simdi32_set(INT_MIN);
+    const simd_int vMinIntron = simdi32_set(minIntron);
+    const simd_int vMaxIntron = simdi32_set(maxIntron);
+    const simd_int vMinDiffAAs = simdi32_set(-maxOverlap);
+    const simd_int vGapOpenPenalty = simdi32_set(setGapOpenPenalty);
+    const simd_int vGapExtendPenalty = simdi32_set(setGapExtendPenalty);
+    int laneIds[VECSIZE_INT];
+    for (int lane = 0; lane < VECSIZE_INT; ++lane) {
+        laneIds[lane] = lane;
+    }
+    int laneBestScores[VECSIZE_INT];
+    int laneBestIds[VECSIZE_INT];
+
     int bestPathScore = 0;
     size_t lastPotentialExonInBestPath = 0;
     
     // dynamic programming to fill in the matrix, go over all rows - previous values have been computed:
     for (size_t currPotentialExonId = 0; currPotentialExonId < numPotentialExonCandidates; ++currPotentialExonId) {
-        for (size_t prevPotentialExonId = 0; prevPotentialExonId < currPotentialExonId; ++prevPotentialExonId) {
+        const int currBitScore = potentialExonCandidates[currPotentialExonId].bitScore;
+        // the first predecessor reaching the maximal score wins, as in the scalar scan.
+        // A predecessor has to improve on the path made of the current candidate alone
+        int bestScore = currBitScore;
+        size_t bestPrevPotentialExonId = currPotentialExonId;
+
+        const simd_int vCurrStrand = simdi32_set(coords.strand[currPotentialExonId]);
+        const simd_int vCurrContigStartMinusOne = simdi32_set(coords.contigStart[currPotentialExonId] - 1);
+        const simd_int vCurrContigEnd = simdi32_set(coords.contigEnd[currPotentialExonId]);
+        const simd_int vCurrTargetStart = simdi32_set(coords.targetMatchStart[currPotentialExonId]);
+        const simd_int vCurrTargetStartMinusOne = simdi32_set(coords.targetMatchStart[currPotentialExonId] - 1);
+        const simd_int vCurrBitScore = simdi32_set(currBitScore);
+        simd_int vBestScore = vIncompatible;
+        simd_int vBestId = simdi32_set(-1);
+        simd_int vPrevIds = simdi_loadu((simd_int *) laneIds);
+        const simd_int vStep = simdi32_set(VECSIZE_INT);
+
+        size_t prevPotentialExonId = 0;
+        for (; prevPotentialExonId + VECSIZE_INT <= currPotentialExonId; prevPotentialExonId += VECSIZE_INT) {
+            simd_int vStrand = simdi_loadu((simd_int *) &coords.strand[prevPotentialExonId]);
+            simd_int vContigEnd = simdi_loadu((simd_int *) &coords.contigEnd[prevPotentialExonId]);
+            simd_int vTargetStart = simdi_loadu((simd_int *) &coords.targetMatchStart[prevPotentialExonId]);
+            simd_int vTargetEnd = simdi_loadu((simd_int *) &coords.targetMatchEnd[prevPotentialExonId]);
+            simd_int vPrevScore = simdi_loadu((simd_int *) &coords.pathScoreWithBonus[prevPotentialExonId]);
+
+            // same checks as isPairCompatible: same strand, no containment,
+            // legal intron length (which excludes contig overlaps), legal target overlap and same order on target
+            simd_int vDiffOnContig = simdi32_sub(vCurrContigStartMinusOne, vContigEnd);
+            simd_int vDiffAAs = simdi32_sub(vCurrTargetStartMinusOne, vTargetEnd);
+            simd_int vCompatible = simdi32_eq(vStrand, vCurrStrand);
+            simd_int vIncompatibleMask = simdi32_gt(vContigEnd, vCurrContigEnd);
+            vIncompatibleMask = simdi_or(vIncompatibleMask, simdi32_gt(vMinIntron, vDiffOnContig));
+            vIncompatibleMask = simdi_or(vIncompatibleMask, simdi32_gt(vDiffOnContig, vMaxIntron));
+            vIncompatibleMask = simdi_or(vIncompatibleMask, simdi32_gt(vMinDiffAAs, vDiffAAs));
+            vIncompatibleMask = simdi_or(vIncompatibleMask, simdi32_gt(vTargetStart, vCurrTargetStart));
+            vCompatible = simdi_andnot(vIncompatibleMask, vCompatible);
+
+            // same as getPenaltyForProtCoords: no penalty for 0 or 1 missing AAs,
+            // otherwise open + extend * (|diffAAs| - 1) for both missing and overlapping AAs
+            simd_int vAbsDiffAAs = simdi32_max(vDiffAAs, simdi32_sub(vZero, vDiffAAs));
+            simd_int vPenalty = simdi32_add(vGapOpenPenalty, simdi32_mul(vGapExtendPenalty, simdi32_sub(vAbsDiffAAs, vOne)));
+            simd_int vIsPenalized = simdi_or(simdi32_gt(vZero, vDiffAAs), simdi32_gt(vDiffAAs, vOne));
+            vPenalty = simdi_and(vPenalty, vIsPenalized);
+
+            simd_int vScore = simdi32_add(simdi32_add(vPrevScore, vPenalty), vCurrBitScore);
+            vScore = simdi8_blend(vIncompatible, vScore, vCompatible);
+
+            // strict comparison keeps the first predecessor with the best score in each lane
+            simd_int vImproved = simdi32_gt(vScore, vBestScore);
+            vBestScore = simdi8_blend(vBestScore, vScore, vImproved);
+            vBestId = simdi8_blend(vBestId, vPrevIds, vImproved);
+            vPrevIds = simdi32_add(vPrevIds, vStep);
+        }
+
+        simdi_storeu((simd_int *) laneBestScores, vBestScore);
+        simdi_storeu((simd_int *) laneBestIds, vBestId);
+        for (int lane = 0; lane < VECSIZE_INT; ++lane) {
+            if (laneBestIds[lane] < 0) {
+                continue;
+            }
+            size_t laneBestId = static_cast<size_t>(laneBestIds[lane]);
+            if ((laneBestScores[lane] > bestScore) ||
+                (laneBestScores[lane] == bestScore && bestPrevPotentialExonId != currPotentialExonId && laneBestId < bestPrevPotentialExonId)) {
+                bestScore = laneBestScores[lane];
+                bestPrevPotentialExonId = laneBestId;
+            }
+        }
+
+        // remaining predecessors that do not fill a vector
+        for (; prevPotentialExonId < currPotentialExonId; ++prevPotentialExonId) {
             size_t pairAaOverlapTarget = 0;
             if (isPairCompatible(potentialExonCandidates[prevPotentialExonId], potentialExonCandidates[currPotentialExonId], 
                                  minIntronLength, maxIntronLength, maxAaOvelap, pairAaOverlapTarget)) {
-                
-                int bestScorePathPrevIsLast = prevIdsAndScoresBestPath[prevPotentialExonId].pathScore;
-                size_t numExonsInPathPrevIsLast = prevIdsAndScoresBestPath[prevPotentialExonId].numExonsInPath;
                 int costOfPrevToCurrTransition = getPenaltyForProtCoords(potentialExonCandidates[prevPotentialExonId], potentialExonCandidates[currPotentialExonId], setGapOpenPenalty, setGapExtendPenalty);
-                
-                size_t currNumExonsWithPrev = numExonsInPathPrevIsLast + 1;
-                int bonusForAddingAnExon = (int) log2(currNumExonsWithPrev); // not the most accurate...
-                int currScoreWithPrev = bestScorePathPrevIsLast + costOfPrevToCurrTransition + potentialExonCandidates[currPotentialExonId].bitScore + bonusForAddingAnExon;
-                
-                // add curr candidate contribution to tcov and path length
-                double currCovWithPrev = prevIdsAndScoresBestPath[prevPotentialExonId].pathTargetCov + potentialExonCandidates[currPotentialExonId].targetCov;
-                int currAALenWithPrev = prevIdsAndScoresBestPath[prevPotentialExonId].pathAALen + potentialExonCandidates[currPotentialExonId].aaLen - pairAaOverlapTarget;
-
-                // update row of currPotentialExon in case of improvement:
-                if (currScoreWithPrev > prevIdsAndScoresBestPath[currPotentialExonId].pathScore) {
-                    prevIdsAndScoresBestPath[currPotentialExonId].prevPotentialExonId = prevPotentialExonId;
-                    prevIdsAndScoresBestPath[currPotentialExonId].pathScore = currScoreWithPrev;
-                    prevIdsAndScoresBestPath[currPotentialExonId].numExonsInPath = currNumExonsWithPrev;
-                    prevIdsAndScoresBestPath[currPotentialExonId].pathTargetCov = currCovWithPrev;
-                    prevIdsAndScoresBestPath[currPotentialExonId].pathAALen = currAALenWithPrev;
+                int currScoreWithPrev = coords.pathScoreWithBonus[prevPotentialExonId] + costOfPrevToCurrTransition + currBitScore;
+                if (currScoreWithPrev > bestScore) {
+                    bestScore = currScoreWithPrev;
+                    bestPrevPotentialExonId = prevPotentialExonId;
                 }
             }
         }
 
+        // update row of currPotentialExon in case of improvement:
+        dpMatrixRow & currRow = prevIdsAndScoresBestPath[currPotentialExonId];
+        if (bestPrevPotentialExonId != currPotentialExonId) {
+            const dpMatrixRow & prevRow = prevIdsAndScoresBestPath[bestPrevPotentialExonId];
+            int diffAAs = coords.targetMatchStart[currPotentialExonId] - coords.targetMatchEnd[bestPrevPotentialExonId] - 1;
+            int pairAaOverlapTarget = (diffAAs < 0) ? -diffAAs : 0;
+
+            currRow.prevPotentialExonId = bestPrevPotentialExonId;
+            currRow.pathScore = bestScore;
+            currRow.numExonsInPath = prevRow.numExonsInPath + 1;
+            // add curr candidate contribution to tcov and path length
+            currRow.pathTargetCov = prevRow.pathTargetCov + potentialExonCandidates[currPotentialExonId].targetCov;
+            currRow.pathAALen = prevRow.pathAALen + potentialExonCandidates[currPotentialExonId].aaLen - pairAaOverlapTarget;
+        }
+        // the row is final, keep its score for the following candidates
+        size_t numExonsWithNext = currRow.numExonsInPath + 1;
+        int bonusForAddingAnExon = (int) log2(numExonsWithNext); // not the most accurate...
+        coords.pathScoreWithBonus[currPotentialExonId] = currRow.pathScore + bonusForAddingAnExon;
+
         // update the global max in case of improvement that covers the target:
         //if (prevIdsAndScoresBestPath[currPotentialExonId].pathTargetCov >= dMetaeukTargetCovThr) {
-        if ((double)prevIdsAndScoresBestPath[currPotentialExonId].pathAALen / (double)targetLength >= dMetaeukTargetCovThr) {
-            if (prevIdsAndScoresBestPath[currPotentialExonId].pathScore > bestPathScore) {
+        if ((double)currRow.pathAALen / (double)targetLength >= dMetaeukTargetCovThr) {
+            if (currRow.pathScore > bestPathScore) {
                 lastPotentialExonInBestPath = currPotentialExonId;
-                bestPathScore = prevIdsAndScoresBestPath[currPotentialExonId].pathScore;
+                bestPathScore = currRow.pathScore;
             }
         }
     }
@@ -210,15 +334,33 @@ int findoptimalsetbydp(std::vector<PotentialExon> & potentialExonCandidates, std
 int collectoptimalset(int argn, const char **argv, const Command& command) {
     LocalParameters& par = LocalParameters::getLocalInstance();
     par.parseParameters(argn, argv, command, true, 0, 0);
+    MMseqsMPI::init(argn, argv);
 
     if (par.minExonAaLength < par.maxAaOverlap) {
         Debug(Debug::ERROR) << "minExonAaLength was set to be smaller than maxAaOverlap. This can cause trouble for very short exons...\n";
         EXIT(EXIT_FAILURE);
     }
 
-    DBReader<unsigned int> resultPerContigReader(par.db1.c_str(), par.db1Index.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
+    DBReader<unsigned int> resultPerContigReader(par.db1.c_str(), par.db1Index.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_PREFETCH);
     resultPerContigReader.open(DBReader<unsigned int>::LINEAR_ACCCESS);
 
+    // each rank works on a range of contigs with a similar volume of search results
+#ifdef HAVE_MPI
+    size_t dbFrom = 0;
+    size_t dbSize = 0;
+    resultPerContigReader.decomposeDomainByAminoAcid(MMseqsMPI::rank, MMseqsMPI::numProc, &dbFrom, &dbSize);
+    std::pair<std::string, std::string> tmpOutput = Util::createTmpFileNames(par.db3, par.db3Index, MMseqsMPI::rank);
+    const char* outData = tmpOutput.first.c_str();
+    const char* outIndex = tmpOutput.second.c_str();
+    const bool merge = true;
+#else
+    size_t dbFrom = 0;
+    size_t dbSize = resultPerContigReader.getSize();
+    const char* outData = par.db3.c_str();
+    const char* outIndex = par.db3Index.c_str();
+    const bool merge = false;
+#endif
+
     DBReader<unsigned int> targetsData(par.db2.c_str(), par.db2Index.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX);
     targetsData.open(DBReader<unsigned int>::NOSORT);
     // get number of AAs in target DB for an E-Value computation
@@ -227,10 +369,10 @@ int collectoptimalset(int argn, const char **argv, const Command& command) {
     double dMetaeukEvalueThr = (double)par.metaeukEvalueThr; // converting to double for precise comparisons
     double dMetaeukTargetCovThr = (double)par.metaeukTargetCovThr;
 
-    DBWriter predWriter(par.db3.c_str(), par.db3Index.c_str(), par.threads, par.compressed, Parameters::DBTYPE_GENERIC_DB);
+    DBWriter predWriter(outData, outIndex, par.threads, par.compressed, Parameters::DBTYPE_GENERIC_DB);
     predWriter.open();
 
-    Debug::Progress progress(resultPerContigReader.getSize());
+    Debug::Progress progress(dbSize);
 
 #pragma omp parallel
     {
@@ -246,6 +388,7 @@ int collectoptimalset(int argn, const char **argv, const Command& command) {
         plusStrandOptimalExonSet.reserve(100);
         std::vector<PotentialExon> minusStrandOptimalExonSet;
         minusStrandOptimalExonSet.reserve(100);
+        PotentialExonCoords potentialExonCoords;
 
         const char *entry[255];
 
@@ -257,7 +400,7 @@ int collectoptimalset(int argn, const char **argv, const Command& command) {
 
 
 #pragma omp for schedule(dynamic, 100)
-        for (size_t id = 0; id < resultPerContigReader.getSize(); id++) {
+        for (size_t id = dbFrom; id < (dbFrom + dbSize); id++) {
             progress.updateProgress();
 
             unsigned int contigKey = resultPerContigReader.getDbKey(id);
@@ -296,8 +439,8 @@ int collectoptimalset(int argn, const char **argv, const Command& command) {
                         EXIT(EXIT_FAILURE);
                     }
                     // sort + dynamic programming to find the optimals set:
-                    int totalBitScorePlus = findoptimalsetbydp(plusStrandPotentialExons, plusStrandOptimalExonSet, par.minIntronLength, par.maxIntronLength, par.maxAaOverlap, par.setGapOpenPenalty, par.setGapExtendPenalty, dMetaeukTargetCovThr);
-                    int totalBitScoreMinus = findoptimalsetbydp(minusStrandPotentialExons, minusStrandOptimalExonSet, par.minIntronLength, par.maxIntronLength, par.maxAaOverlap, par.setGapOpenPenalty, par.setGapExtendPenalty, dMetaeukTargetCovThr);
+                    int totalBitScorePlus = findoptimalsetbydp(plusStrandPotentialExons, plusStrandOptimalExonSet, potentialExonCoords, par.minIntronLength, par.maxIntronLength, par.maxAaOverlap, par.setGapOpenPenalty, par.setGapExtendPenalty, dMetaeukTargetCovThr);
+                    int totalBitScoreMinus = findoptimalsetbydp(minusStrandPotentialExons, minusStrandOptimalExonSet, potentialExonCoords, par.minIntronLength, par.maxIntronLength, par.maxAaOverlap, par.setGapOpenPenalty, par.setGapExtendPenalty, dMetaeukTargetCovThr);
 
                     // write optimal sets to result file:
                     if (plusStrandOptimalExonSet.size() > 0) {
@@ -347,8 +490,8 @@ int collectoptimalset(int argn, const char **argv, const Command& command) {
 
             // one last time - required for the matches of the contig against the last target
             // sort + dynamic programming to find the optimals set:
-            int totalBitScorePlus = findoptimalsetbydp(plusStrandPotentialExons, plusStrandOptimalExonSet, par.minIntronLength, par.maxIntronLength, par.maxAaOverlap, par.setGapOpenPenalty, par.setGapExtendPenalty, dMetaeukTargetCovThr);
-            int totalBitScoreMinus = findoptimalsetbydp(minusStrandPotentialExons, minusStrandOptimalExonSet, par.minIntronLength, par.maxIntronLength, par.maxAaOverlap, par.setGapOpenPenalty, par.setGapExtendPenalty, dMetaeukTargetCovThr);
+            int totalBitScorePlus = findoptimalsetbydp(plusStrandPotentialExons, plusStrandOptimalExonSet, potentialExonCoords, par.minIntronLength, par.maxIntronLength, par.maxAaOverlap, par.setGapOpenPenalty, par.setGapExtendPenalty, dMetaeukTargetCovThr);
+            int totalBitScoreMinus = findoptimalsetbydp(minusStrandPotentialExons, minusStrandOptimalExonSet, potentialExonCoords, par.minIntronLength, par.maxIntronLength, par.maxAaOverlap, par.setGapOpenPenalty, par.setGapExtendPenalty, dMetaeukTargetCovThr);
             
             // write optimal sets to result file:
             if (plusStrandOptimalExonSet.size() > 0) {
@@ -386,7 +529,19 @@ int collectoptimalset(int argn, const char **argv, const Command& command) {
         }
     }
 
-    predWriter.close();
+    predWriter.close(merge);
     resultPerContigReader.close();
+
+#ifdef HAVE_MPI
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (MMseqsMPI::isMaster()) {
+        std::vector<std::pair<std::string, std::string>> splitFiles;
+        for (int i = 0; i < MMseqsMPI::numProc; ++i) {
+            splitFiles.push_back(Util::createTmpFileNames(par.db3, par.db3Index, i));
+        }
+        DBWriter::mergeResults(par.db3, par.db3Index, splitFiles);
+    }
+#endif
+
     return EXIT_SUCCESS;
 }
\ No newline at end of file
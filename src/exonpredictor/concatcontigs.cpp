@@ -0,0 +1,122 @@
+#include "LocalParameters.h"
+#include "DBReader.h"
+#include "DBWriter.h"
+#include "Debug.h"
+#include "Util.h"
+#include "FileUtil.h"
+
+#include <climits>
+
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+// copies all entries of reader to writer, shifting their keys by keyOffset
+// entries are copied as they are stored, compressed entries are not recompressed
+void copyShiftedEntries(DBReader<unsigned int> & reader, DBWriter & writer, const size_t keyOffset, const bool isCompressed) {
+#pragma omp parallel
+    {
+        unsigned int thread_idx = 0;
+#ifdef OPENMP
+        thread_idx = static_cast<unsigned int>(omp_get_thread_num());
+#endif
+
+#pragma omp for schedule(dynamic, 100)
+        for (size_t id = 0; id < reader.getSize(); id++) {
+            unsigned int newKey = static_cast<unsigned int>(keyOffset + reader.getDbKey(id));
+            char* data = reader.getDataUncompressed(id);
+            size_t originalLength = reader.getEntryLen(id);
+            size_t entryLength = std::max(originalLength, static_cast<size_t>(1)) - 1;
+
+            if (isCompressed) {
+                // copy also the null byte since it contains the information if compressed or not
+                entryLength = *(reinterpret_cast<unsigned int *>(data)) + sizeof(unsigned int) + 1;
+                writer.writeData(data, entryLength, newKey, thread_idx, false, false);
+            } else {
+                writer.writeData(data, entryLength, newKey, thread_idx, true, false);
+            }
+            writer.writeIndexEntry(newKey, writer.getStart(thread_idx), originalLength, thread_idx);
+        }
+    }
+}
+
+int concatcontigs(int argn, const char **argv, const Command& command) {
+    LocalParameters& par = LocalParameters::getLocalInstance();
+    par.parseParameters(argn, argv, command, true, Parameters::PARSE_VARIADIC, 0);
+
+    // the last path is the output, all others are the contig DBs of the samples
+    std::string outDb = par.filenames.back();
+    par.filenames.pop_back();
+    std::string outDbIndex = outDb + ".index";
+    std::string outHeaderDb = outDb + "_h";
+    std::string outHeaderDbIndex = outDb + "_h.index";
+
+    DBWriter dataWriter(outDb.c_str(), outDbIndex.c_str(), par.threads, 0, Parameters::DBTYPE_OMIT_FILE);
+    dataWriter.open();
+    DBWriter headerWriter(outHeaderDb.c_str(), outHeaderDbIndex.c_str(), par.threads, 0, Parameters::DBTYPE_OMIT_FILE);
+    headerWriter.open();
+
+    // each line lists: sample index, key offset of the sample, sample contigs DB
+    std::string samplesFileName = outDb + ".samples";
+    FILE* samplesFile = FileUtil::openAndDelete(samplesFileName.c_str(), "w");
+
+    int dataDbtype = -1;
+    int headerDbtype = -1;
+    bool isDataCompressed = false;
+    bool isHeaderCompressed = false;
+
+    // the keys of each sample are placed after the largest key of the previous sample
+    // so that every concatenated key identifies its sample by a range and its original key by a difference
+    size_t keyOffset = 0;
+    for (size_t sampleIdx = 0; sampleIdx < par.filenames.size(); ++sampleIdx) {
+        std::string sampleDb = par.filenames[sampleIdx];
+        std::string sampleHeaderDb = sampleDb + "_h";
+
+        DBReader<unsigned int> contigsData(sampleDb.c_str(), (sampleDb + ".index").c_str(), par.threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
+        contigsData.open(DBReader<unsigned int>::NOSORT);
+        DBReader<unsigned int> contigsHeaders(sampleHeaderDb.c_str(), (sampleHeaderDb + ".index").c_str(), par.threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
+        contigsHeaders.open(DBReader<unsigned int>::NOSORT);
+
+        if (sampleIdx == 0) {
+            dataDbtype = contigsData.getDbtype();
+            headerDbtype = contigsHeaders.getDbtype();
+            isDataCompressed = contigsData.isCompressed();
+            isHeaderCompressed = contigsHeaders.isCompressed();
+        } else if ((contigsData.isCompressed() != isDataCompressed) || (contigsHeaders.isCompressed() != isHeaderCompressed)) {
+            Debug(Debug::ERROR) << "Contigs DB " << sampleDb << " is not compressed like " << par.filenames[0] << ". All samples should be either compressed or not.\n";
+            EXIT(EXIT_FAILURE);
+        }
+
+        size_t sampleLastKey = (contigsData.getSize() > 0) ? contigsData.getLastKey() : 0;
+        if ((keyOffset + sampleLastKey) >= UINT_MAX) {
+            Debug(Debug::ERROR) << "The contig keys of all samples do not fit into a single DB. Please split the samples into smaller batches.\n";
+            EXIT(EXIT_FAILURE);
+        }
+
+        copyShiftedEntries(contigsData, dataWriter, keyOffset, isDataCompressed);
+        copyShiftedEntries(contigsHeaders, headerWriter, keyOffset, isHeaderCompressed);
+
+        std::string sampleLine = SSTR(sampleIdx) + "\t" + SSTR(keyOffset) + "\t" + sampleDb + "\n";
+        if (fwrite(sampleLine.c_str(), sizeof(char), sampleLine.size(), samplesFile) != sampleLine.size()) {
+            Debug(Debug::ERROR) << "Cannot write to samples file " << samplesFileName << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+
+        keyOffset += (sampleLastKey + 1);
+
+        contigsData.close();
+        contigsHeaders.close();
+    }
+
+    if (fclose(samplesFile) != 0) {
+        Debug(Debug::ERROR) << "Cannot close file " << samplesFileName << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+
+    dataWriter.close(true);
+    DBWriter::writeDbtypeFile(outDb.c_str(), dataDbtype, isDataCompressed);
+    headerWriter.close(true);
+    DBWriter::writeDbtypeFile(outHeaderDb.c_str(), headerDbtype, isHeaderCompressed);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,163 @@
+#include "LocalParameters.h"
+#include "DBReader.h"
+#include "DBWriter.h"
+#include "Debug.h"
+#include "Util.h"
+
+#include <cmath>
+
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+const int CODING_ALPHABET_SIZE = 20;
+const size_t MAX_MODEL_RESIDUES = 100000000;
+
+// maps the 20 standard amino acids to 0..19, all other characters to -1
+static void initCodingAlphabet(int * aaToIndex) {
+    const char * aminoAcids = "ACDEFGHIKLMNPQRSTVWY";
+    for (int i = 0; i < 256; ++i) {
+        aaToIndex[i] = -1;
+    }
+    for (int i = 0; i < CODING_ALPHABET_SIZE; ++i) {
+        aaToIndex[static_cast<unsigned char>(aminoAcids[i])] = i;
+        aaToIndex[static_cast<unsigned char>(tolower(aminoAcids[i]))] = i;
+    }
+}
+
+// counts the dipeptides of every stride-th entry of reader
+static void countDipeptides(DBReader<unsigned int> & reader, const int * aaToIndex, const size_t stride, double * counts) {
+    const size_t pairs = CODING_ALPHABET_SIZE * CODING_ALPHABET_SIZE;
+    for (size_t i = 0; i < pairs; ++i) {
+        // pseudocount
+        counts[i] = 1.0;
+    }
+#pragma omp parallel
+    {
+        unsigned int thread_idx = 0;
+#ifdef OPENMP
+        thread_idx = static_cast<unsigned int>(omp_get_thread_num());
+#endif
+        std::vector<size_t> threadCounts(pairs, 0);
+#pragma omp for schedule(dynamic, 100)
+        for (size_t id = 0; id < reader.getSize(); id += stride) {
+            const char * seq = reader.getData(id, thread_idx);
+            const size_t seqLen = reader.getSeqLen(id);
+            int prev = -1;
+            for (size_t pos = 0; pos < seqLen; ++pos) {
+                const int curr = aaToIndex[static_cast<unsigned char>(seq[pos])];
+                if (prev != -1 && curr != -1) {
+                    threadCounts[prev * CODING_ALPHABET_SIZE + curr]++;
+                }
+                prev = curr;
+            }
+        }
+#pragma omp critical
+        {
+            for (size_t i = 0; i < pairs; ++i) {
+                counts[i] += threadCounts[i];
+            }
+        }
+    }
+}
+
+int filternoncoding(int argn, const char **argv, const Command& command) {
+    LocalParameters& par = LocalParameters::getLocalInstance();
+    par.parseParameters(argn, argv, command, true, 0, 0);
+
+    DBReader<unsigned int> fragmentsData(par.db1.c_str(), par.db1Index.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
+    fragmentsData.open(DBReader<unsigned int>::NOSORT);
+    DBReader<unsigned int> fragmentsHeaders(par.hdr1.c_str(), par.hdr1Index.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
+    fragmentsHeaders.open(DBReader<unsigned int>::NOSORT);
+    DBReader<unsigned int> targetsData(par.db2.c_str(), par.db2Index.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
+    targetsData.open(DBReader<unsigned int>::NOSORT);
+
+    if (Parameters::isEqualDbtype(targetsData.getDbtype(), Parameters::DBTYPE_AMINO_ACIDS) == false) {
+        Debug(Debug::ERROR) << "filternoncoding needs a protein sequence target database\n";
+        EXIT(EXIT_FAILURE);
+    }
+
+    // the coding model is the dipeptide composition of the targets, the noncoding model the composition of all fragments,
+    // since most stop-to-stop fragments of a eukaryotic contig are translated noncoding sequence
+    int aaToIndex[256];
+    initCodingAlphabet(aaToIndex);
+    const size_t pairs = CODING_ALPHABET_SIZE * CODING_ALPHABET_SIZE;
+    std::vector<double> targetCounts(pairs);
+    std::vector<double> fragmentCounts(pairs);
+    const size_t targetStride = std::max(targetsData.getAminoAcidDBSize() / MAX_MODEL_RESIDUES, static_cast<size_t>(1));
+    const size_t fragmentStride = std::max(fragmentsData.getAminoAcidDBSize() / MAX_MODEL_RESIDUES, static_cast<size_t>(1));
+    countDipeptides(targetsData, aaToIndex, targetStride, targetCounts.data());
+    countDipeptides(fragmentsData, aaToIndex, fragmentStride, fragmentCounts.data());
+    targetsData.close();
+
+    double targetTotal = 0.0;
+    double fragmentTotal = 0.0;
+    for (size_t i = 0; i < pairs; ++i) {
+        targetTotal += targetCounts[i];
+        fragmentTotal += fragmentCounts[i];
+    }
+    std::vector<float> logOdds(pairs);
+    for (size_t i = 0; i < pairs; ++i) {
+        logOdds[i] = static_cast<float>(log2((targetCounts[i] / targetTotal) / (fragmentCounts[i] / fragmentTotal)));
+    }
+
+    DBWriter dataWriter(par.db3.c_str(), par.db3Index.c_str(), par.threads, par.compressed, fragmentsData.getDbtype());
+    dataWriter.open();
+    DBWriter headerWriter(par.hdr3.c_str(), par.hdr3Index.c_str(), par.threads, Parameters::withoutDictionary(par.compressed), Parameters::DBTYPE_GENERIC_DB);
+    headerWriter.open();
+
+    size_t keptFragments = 0;
+    size_t keptResidues = 0;
+    Debug::Progress progress(fragmentsData.getSize());
+#pragma omp parallel
+    {
+        unsigned int thread_idx = 0;
+#ifdef OPENMP
+        thread_idx = static_cast<unsigned int>(omp_get_thread_num());
+#endif
+
+#pragma omp for schedule(dynamic, 100) reduction(+: keptFragments, keptResidues)
+        for (size_t id = 0; id < fragmentsData.getSize(); ++id) {
+            progress.updateProgress();
+            const char * seq = fragmentsData.getData(id, thread_idx);
+            const size_t seqLen = fragmentsData.getSeqLen(id);
+            // an exon usually covers only a part of its stop-to-stop fragment,
+            // so the coding score is the score of the best segment of the fragment
+            float codingScore = 0.0;
+            float segmentScore = 0.0;
+            int prev = -1;
+            for (size_t pos = 0; pos < seqLen; ++pos) {
+                const int curr = aaToIndex[static_cast<unsigned char>(seq[pos])];
+                if (prev != -1 && curr != -1) {
+                    segmentScore = std::max(segmentScore + logOdds[prev * CODING_ALPHABET_SIZE + curr], 0.0f);
+                    codingScore = std::max(codingScore, segmentScore);
+                }
+                prev = curr;
+            }
+            if (codingScore < par.minCodingScore) {
+                continue;
+            }
+
+            const unsigned int key = fragmentsData.getDbKey(id);
+            dataWriter.writeStart(thread_idx);
+            dataWriter.writeAdd(seq, seqLen, thread_idx);
+            dataWriter.writeAdd("\n", 1, thread_idx);
+            dataWriter.writeEnd(key, thread_idx);
+            const char * header = fragmentsHeaders.getDataByDBKey(key, thread_idx);
+            headerWriter.writeData(header, strlen(header), key, thread_idx);
+            keptFragments++;
+            keptResidues += seqLen;
+        }
+    }
+    dataWriter.close(true);
+    headerWriter.close(true);
+
+    const size_t totalResidues = fragmentsData.getAminoAcidDBSize();
+    Debug(Debug::INFO) << "Kept " << keptFragments << " of " << fragmentsData.getSize() << " fragments with a coding score of at least "
+                       << par.minCodingScore << " bits (" << SSTR(100.0 * keptResidues / std::max(totalResidues, static_cast<size_t>(1))) << "% of the residues)\n";
+
+    fragmentsHeaders.close();
+    fragmentsData.close();
+
+    return EXIT_SUCCESS;
+}
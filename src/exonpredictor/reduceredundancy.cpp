@@ -161,20 +161,43 @@ void writePredsClusters (std::vector<Prediction> &predictions, char * clusterBuf
 int reduceredundancy(int argn, const char **argv, const Command& command) {
     LocalParameters& par = LocalParameters::getLocalInstance();
     par.parseParameters(argn, argv, command, true, 0, 0);
+    MMseqsMPI::init(argn, argv);
 
     // db1 = input, predictions per contig
-    DBReader<unsigned int> predsPerContig(par.db1.c_str(), par.db1Index.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
+    DBReader<unsigned int> predsPerContig(par.db1.c_str(), par.db1Index.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_PREFETCH);
     predsPerContig.open(DBReader<unsigned int>::LINEAR_ACCCESS);
 
+    // each rank works on a range of contigs with a similar volume of predictions
+#ifdef HAVE_MPI
+    size_t dbFrom = 0;
+    size_t dbSize = 0;
+    predsPerContig.decomposeDomainByAminoAcid(MMseqsMPI::rank, MMseqsMPI::numProc, &dbFrom, &dbSize);
+    std::pair<std::string, std::string> tmpGroupedPredictions = Util::createTmpFileNames(par.db2, par.db2Index, MMseqsMPI::rank);
+    std::pair<std::string, std::string> tmpRepToMembers = Util::createTmpFileNames(par.db3, par.db3Index, MMseqsMPI::rank);
+    const char* outGroupedPredictions = tmpGroupedPredictions.first.c_str();
+    const char* outGroupedPredictionsIndex = tmpGroupedPredictions.second.c_str();
+    const char* outRepToMembers = tmpRepToMembers.first.c_str();
+    const char* outRepToMembersIndex = tmpRepToMembers.second.c_str();
+    const bool merge = true;
+#else
+    size_t dbFrom = 0;
+    size_t dbSize = predsPerContig.getSize();
+    const char* outGroupedPredictions = par.db2.c_str();
+    const char* outGroupedPredictionsIndex = par.db2Index.c_str();
+    const char* outRepToMembers = par.db3.c_str();
+    const char* outRepToMembersIndex = par.db3Index.c_str();
+    const bool merge = false;
+#endif
+
     // db2 = output, DP format of representative predictions (par.overlapAllowed will exclude overlaps by default)
-    DBWriter writerGroupedPredictions(par.db2.c_str(), par.db2Index.c_str(), par.threads, par.compressed, Parameters::DBTYPE_GENERIC_DB);
+    DBWriter writerGroupedPredictions(outGroupedPredictions, outGroupedPredictionsIndex, par.threads, par.compressed, Parameters::DBTYPE_GENERIC_DB);
     writerGroupedPredictions.open();
 
     // db3 = output, grouping of predictions: T,S of representatives to T,S of prediction
-    DBWriter writerRepToMembers(par.db3.c_str(), par.db3Index.c_str(), par.threads, par.compressed, Parameters::DBTYPE_GENERIC_DB);
+    DBWriter writerRepToMembers(outRepToMembers, outRepToMembersIndex, par.threads, par.compressed, Parameters::DBTYPE_GENERIC_DB);
     writerRepToMembers.open();
 
-    Debug::Progress progress(predsPerContig.getSize());
+    Debug::Progress progress(dbSize);
 #pragma omp parallel
     {
         unsigned int thread_idx = 0;
@@ -204,7 +227,7 @@ int reduceredundancy(int argn, const char **argv, const Command& command) {
         char clusterBuffer[1000];
 
 #pragma omp for schedule(dynamic, 100)
-        for (size_t id = 0; id < predsPerContig.getSize(); id++) {
+        for (size_t id = dbFrom; id < (dbFrom + dbSize); id++) {
             progress.updateProgress();
 
             unsigned int contigKey = predsPerContig.getDbKey(id);
@@ -296,9 +319,23 @@ int reduceredundancy(int argn, const char **argv, const Command& command) {
             minusContigRepPreds.clear();
         }
     }
-    writerRepToMembers.close();
-    writerGroupedPredictions.close();
+    writerRepToMembers.close(merge);
+    writerGroupedPredictions.close(merge);
     predsPerContig.close();
 
+#ifdef HAVE_MPI
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (MMseqsMPI::isMaster()) {
+        std::vector<std::pair<std::string, std::string>> splitGroupedPredictions;
+        std::vector<std::pair<std::string, std::string>> splitRepToMembers;
+        for (int i = 0; i < MMseqsMPI::numProc; ++i) {
+            splitGroupedPredictions.push_back(Util::createTmpFileNames(par.db2, par.db2Index, i));
+            splitRepToMembers.push_back(Util::createTmpFileNames(par.db3, par.db3Index, i));
+        }
+        DBWriter::mergeResults(par.db2, par.db2Index, splitGroupedPredictions);
+        DBWriter::mergeResults(par.db3, par.db3Index, splitRepToMembers);
+    }
+#endif
+
     return EXIT_SUCCESS;
 }
@@ -14,17 +14,26 @@
 #include <omp.h>
 #endif
 
+// the alignment columns of a hit are written back unchanged, they are kept as text in a per-thread buffer
+struct OrfHit {
+    unsigned int targetKey;
+    unsigned int orfKey;
+    size_t orfIdx;
+    size_t recordOffset;
+    size_t recordLength;
+};
+
 struct compareByTarget {
-    bool operator() (const std::pair<Matcher::result_t, Matcher::result_t>& lhs, const std::pair<Matcher::result_t, Matcher::result_t>& rhs) const {
+    bool operator() (const OrfHit& lhs, const OrfHit& rhs) const {
         // sort by target id
-        if (lhs.first.dbKey < rhs.first.dbKey) {
+        if (lhs.targetKey < rhs.targetKey) {
             return true;
         }
-        if (lhs.first.dbKey > rhs.first.dbKey) {
+        if (lhs.targetKey > rhs.targetKey) {
             return false;
         }
         // if a contig hits the same target with two orfs - sort by orf key
-        if (lhs.second.dbKey < rhs.second.dbKey) {
+        if (lhs.orfKey < rhs.orfKey) {
             return true;
         }
         return false;
@@ -141,8 +150,12 @@ int resultspercontig(int argc, const char **argv, const Command &command) {
         std::string ss;
         ss.reserve(1024);
 
-        std::vector<std::pair<Matcher::result_t, Matcher::result_t>> results;
+        std::vector<OrfHit> results;
         results.reserve(300);
+        std::vector<Matcher::result_t> orfsToContig;
+        std::string records;
+        records.reserve(65536);
+        Matcher::result_view_t view;
 
 #pragma omp for schedule(dynamic, 10)
         for (size_t i = 0; i < entryCount; ++i) {
@@ -163,18 +176,33 @@ int resultspercontig(int argc, const char **argv, const Command &command) {
                     continue;
                 }
                 
-                Matcher::result_t orfToContig = Orf::getFromDatabase(orfsHeaderId, contigsReader, orfHeadersReader, thread_idx);
-                // hack orfToContig to retain the orf key and not the contig key (the contig will serve as the final db key)
-                orfToContig.dbKey = orfKey;
-
                 size_t orfId = alnDbr.getId(orfKey);
                 // this is needed when alnDbr does not contain all identifiers of the queryDB
                 if (orfId == UINT_MAX) {
                     continue;
                 }
+
+                Matcher::result_t orfToContig = Orf::getFromDatabase(orfsHeaderId, contigsReader, orfHeadersReader, thread_idx);
+                // hack orfToContig to retain the orf key and not the contig key (the contig will serve as the final db key)
+                orfToContig.dbKey = orfKey;
+                orfsToContig.emplace_back(orfToContig);
+
+                // only the target key is needed for sorting, the record is copied without its orf positions
                 char *data = alnDbr.getData(orfId, thread_idx);
                 while (*data != '\0') {
-                    results.emplace_back(std::make_pair(Matcher::parseAlignmentRecord(data, true), orfToContig));
+                    Matcher::parseAlignmentRecord(data, Matcher::COLUMN_KEY, view);
+                    OrfHit hit;
+                    hit.targetKey = view.dbKey;
+                    hit.orfKey = orfKey;
+                    hit.orfIdx = orfsToContig.size() - 1;
+                    hit.recordOffset = records.size();
+                    records.append(view.record, view.recordLength);
+                    if (view.backtrace != NULL) {
+                        records.push_back('\t');
+                        records.append(view.backtrace, view.backtraceLength);
+                    }
+                    hit.recordLength = records.size() - hit.recordOffset;
+                    results.emplace_back(hit);
                     data = Util::skipLine(data);
                 }
             }
@@ -182,21 +210,18 @@ int resultspercontig(int argc, const char **argv, const Command &command) {
             std::stable_sort(results.begin(), results.end(), compareByTarget());
 
             for (size_t i = 0; i < results.size(); i++) {
-                Matcher::result_t &orfToTarget = results[i].first;
-                bool hasBacktrace = (orfToTarget.backtrace.size() > 0);
-                size_t len = Matcher::resultToBuffer(buffer, orfToTarget, hasBacktrace, false);
-                // -1 for newline
-                ss.append(buffer, len - 1);
+                ss.append(records, results[i].recordOffset, results[i].recordLength);
                 // add "\t"
                 ss.append("\t");
-                Matcher::result_t &orfToContig = results[i].second;
-                len = Matcher::resultToBuffer(buffer, orfToContig, false, false);
+                size_t len = Matcher::resultToBuffer(buffer, orfsToContig[results[i].orfIdx], false, false);
                 ss.append(buffer, len);
             }
             resultWriter.writeData(ss.c_str(), ss.length(), contigKey, thread_idx);
 
             ss.clear();
             results.clear();
+            orfsToContig.clear();
+            records.clear();
         }
     }
     resultWriter.close();
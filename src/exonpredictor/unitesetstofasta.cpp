@@ -157,6 +157,7 @@ void preparePredHeaderToInfo (const unsigned int contigKey, const Prediction & p
 int unitesetstofasta(int argn, const char **argv, const Command& command) {
     LocalParameters& par = LocalParameters::getLocalInstance();
     par.parseParameters(argn, argv, command, true, 0, 0);
+    MMseqsMPI::init(argn, argv);
 
     // db1 = contigsDB (data + header):
     DBReader<unsigned int> contigsData(par.db1.c_str(), par.db1Index.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
@@ -170,33 +171,48 @@ int unitesetstofasta(int argn, const char **argv, const Command& command) {
     targetsHeaders.open(DBReader<unsigned int>::NOSORT);
 
     // db3 = predictions per contig
-    DBReader<unsigned int> predsPerContig(par.db3.c_str(), par.db3Index.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA);
+    DBReader<unsigned int> predsPerContig(par.db3.c_str(), par.db3Index.c_str(), par.threads, DBReader<unsigned int>::USE_INDEX|DBReader<unsigned int>::USE_DATA|DBReader<unsigned int>::USE_PREFETCH);
     predsPerContig.open(DBReader<unsigned int>::LINEAR_ACCCESS);
     
     std::string fastaAaFileName = par.db4 + ".fas";
     std::string fastaAaFileNameIndex = par.db4Index;
+    std::string fastaCodonFileName = par.db4 + ".codon.fas";
+    std::string fastaCodonFileNameIndex = par.db4 + ".codon.index";
+    std::string mapFileName = par.db4 + ".headersMap.tsv";
+    std::string mapFileNameIndex = par.db4 + ".headersMap.tsv.index"; // not used
+
+    // each rank works on a range of contigs with a similar volume of predictions
+#ifdef HAVE_MPI
+    size_t dbFrom = 0;
+    size_t dbSize = 0;
+    predsPerContig.decomposeDomainByAminoAcid(MMseqsMPI::rank, MMseqsMPI::numProc, &dbFrom, &dbSize);
+    std::pair<std::string, std::string> outFastaAa = Util::createTmpFileNames(fastaAaFileName, fastaAaFileNameIndex, MMseqsMPI::rank);
+    std::pair<std::string, std::string> outFastaCodon = Util::createTmpFileNames(fastaCodonFileName, fastaCodonFileNameIndex, MMseqsMPI::rank);
+    std::pair<std::string, std::string> outMap = Util::createTmpFileNames(mapFileName, mapFileNameIndex, MMseqsMPI::rank);
+#else
+    size_t dbFrom = 0;
+    size_t dbSize = predsPerContig.getSize();
+    std::pair<std::string, std::string> outFastaAa = std::make_pair(fastaAaFileName, fastaAaFileNameIndex);
+    std::pair<std::string, std::string> outFastaCodon = std::make_pair(fastaCodonFileName, fastaCodonFileNameIndex);
+    std::pair<std::string, std::string> outMap = std::make_pair(mapFileName, mapFileNameIndex);
+#endif
 
     // out AA fasta
-    DBWriter fastaAaWriter(fastaAaFileName.c_str(), fastaAaFileNameIndex.c_str(), par.threads, 0, Parameters::DBTYPE_OMIT_FILE);
+    DBWriter fastaAaWriter(outFastaAa.first.c_str(), outFastaAa.second.c_str(), par.threads, 0, Parameters::DBTYPE_OMIT_FILE);
     fastaAaWriter.open();
 
-    std::string fastaCodonFileName = par.db4 + ".codon.fas";
-    std::string fastaCodonFileNameIndex = par.db4 + ".codon.index";
-
     // out codon fasta
-    DBWriter fastaCodonWriter(fastaCodonFileName.c_str(), fastaCodonFileNameIndex.c_str(), par.threads, 0, Parameters::DBTYPE_OMIT_FILE);
+    DBWriter fastaCodonWriter(outFastaCodon.first.c_str(), outFastaCodon.second.c_str(), par.threads, 0, Parameters::DBTYPE_OMIT_FILE);
     fastaCodonWriter.open();
 
     // out mapping - MetaEuk header to contig, target, etc. Mimicking the headers produced by extractorfs so this can later be plugged in easily
-    std::string mapFileName = par.db4 + ".headersMap.tsv";
-    std::string mapFileNameIndex = par.db4 + ".headersMap.tsv.index"; // not used
-    DBWriter mapWriter(mapFileName.c_str(), mapFileNameIndex.c_str(), par.threads, 0, Parameters::DBTYPE_OMIT_FILE);
+    DBWriter mapWriter(outMap.first.c_str(), outMap.second.c_str(), par.threads, 0, Parameters::DBTYPE_OMIT_FILE);
     mapWriter.open();
 
     // for the translated result
     TranslateNucl translateNucl(static_cast<TranslateNucl::GenCode>(par.translationTable));
 
-    Debug::Progress progress(predsPerContig.getSize());
+    Debug::Progress progress(dbSize);
 #pragma omp parallel
     {
         unsigned int thread_idx = 0;
@@ -216,7 +232,7 @@ int unitesetstofasta(int argn, const char **argv, const Command& command) {
         char* translatedSeqBuff = (char*)malloc(translatedSeqBuffSize);
 
 #pragma omp for schedule(dynamic, 100)
-        for (size_t id = 0; id < predsPerContig.getSize(); id++) {
+        for (size_t id = dbFrom; id < (dbFrom + dbSize); id++) {
             progress.updateProgress();
 
             unsigned int contigKey = predsPerContig.getDbKey(id);
@@ -423,11 +439,31 @@ int unitesetstofasta(int argn, const char **argv, const Command& command) {
     }
     fastaAaWriter.close(true);
     fastaCodonWriter.close(true);
-    FileUtil::remove(fastaCodonFileNameIndex.c_str());
-    FileUtil::remove(fastaAaFileNameIndex.c_str());
-
     mapWriter.close(true);
-    FileUtil::remove(mapFileNameIndex.c_str());
+
+#ifdef HAVE_MPI
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (MMseqsMPI::isMaster()) {
+        std::vector<std::pair<std::string, std::string>> splitFastaAa;
+        std::vector<std::pair<std::string, std::string>> splitFastaCodon;
+        std::vector<std::pair<std::string, std::string>> splitMap;
+        for (int i = 0; i < MMseqsMPI::numProc; ++i) {
+            splitFastaAa.push_back(Util::createTmpFileNames(fastaAaFileName, fastaAaFileNameIndex, i));
+            splitFastaCodon.push_back(Util::createTmpFileNames(fastaCodonFileName, fastaCodonFileNameIndex, i));
+            splitMap.push_back(Util::createTmpFileNames(mapFileName, mapFileNameIndex, i));
+        }
+        // the ranks hold consecutive ranges of contigs, so their files are concatenated in rank order
+        DBWriter::mergeResults(fastaAaFileName, fastaAaFileNameIndex, splitFastaAa);
+        DBWriter::mergeResults(fastaCodonFileName, fastaCodonFileNameIndex, splitFastaCodon);
+        DBWriter::mergeResults(mapFileName, mapFileNameIndex, splitMap);
+    }
+#endif
+
+    if (MMseqsMPI::isMaster()) {
+        FileUtil::remove(fastaCodonFileNameIndex.c_str());
+        FileUtil::remove(fastaAaFileNameIndex.c_str());
+        FileUtil::remove(mapFileNameIndex.c_str());
+    }
  
     contigsData.close();
     contigsHeaders.close();
@@ -31,6 +31,15 @@ std::vector<struct Command> commands = {
                                    {"targetsDB", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA, &DbValidator::flatfile},
                                    {"predictionsFasta", DbType::ACCESS_MODE_OUTPUT, DbType::NEED_DATA, &DbValidator::flatfile},
                                    {"tmpDir", DbType::ACCESS_MODE_OUTPUT, DbType::NEED_DATA, &DbValidator::directory}}},
+        {"predictbatch",             predictbatch,            &localPar.easypredictworkflow,    COMMAND_MAIN,
+                "Predict protein-coding genes from the contigs of many samples with a single search against the targets",
+                "Concatenates the contigs of all samples, runs predictexons and reduceredundancy once and writes a fasta of the predictions for each sample, as easy-predict would",
+                "Eli Levy Karin <eli.levy.karin@gmail.com>",
+                "<i:contigsDB1> ... <i:contigsDBN> <i:targetsDB> <o:predictionsBasename> <tmpDir>",
+                CITATION_METAEUK, {{"contigsDB", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA|DbType::NEED_HEADER|DbType::VARIADIC, &DbValidator::nuclDb},
+                                   {"targetsDB", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA, &DbValidator::sequenceDb},
+                                   {"predictionsBasename", DbType::ACCESS_MODE_OUTPUT, DbType::NEED_DATA, &DbValidator::flatfile},
+                                   {"tmpDir", DbType::ACCESS_MODE_OUTPUT, DbType::NEED_DATA, &DbValidator::directory}}},
         {"taxtocontig",             taxtocontig,            &localPar.taxpercontigworkflow,    COMMAND_MAIN,
                 "Assign taxonomic labels to predictions and aggregate them per contig",
                 "The LCA of a majority of predictions will be assigned to their contig",
@@ -78,6 +87,21 @@ std::vector<struct Command> commands = {
                                    {"fragmentsDb", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA, &DbValidator::sequenceDb},
                                    {"fragmentToTargetSearchRes", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA, &DbValidator::resultDb},
                                    {"contigToSearchRes", DbType::ACCESS_MODE_OUTPUT, DbType::NEED_DATA, NULL}}},
+        {"concatcontigs",             concatcontigs,            &localPar.onlythreads,    COMMAND_EXPERT,
+                "Concatenate the contigs DBs of several samples into one DB",
+                "The keys of each sample are shifted by an offset, the sample index and offset are listed in contigsDB.samples",
+                "Eli Levy Karin <eli.levy.karin@gmail.com>",
+                "<i:contigsDB1> ... <i:contigsDBN> <o:contigsDB>",
+                CITATION_METAEUK, {{"contigsDB", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA|DbType::NEED_HEADER|DbType::VARIADIC, &DbValidator::nuclDb},
+                                   {"contigsDB", DbType::ACCESS_MODE_OUTPUT, DbType::NEED_DATA, &DbValidator::nuclDb}}},
+        {"filternoncoding",             filternoncoding,            &localPar.filternoncoding,    COMMAND_EXPERT,
+                "Remove fragments that are unlikely to be coding before the search",
+                "Each fragment is scored by its best segment under the dipeptide log-odds of the targets against all fragments. Fragments scoring below --min-coding-score are removed",
+                "Eli Levy Karin <eli.levy.karin@gmail.com>",
+                "<i:fragmentsDB> <i:targetsDB> <o:codingFragmentsDB>",
+                CITATION_METAEUK, {{"fragmentsDB", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA|DbType::NEED_HEADER, &DbValidator::aaDb},
+                                   {"targetsDB", DbType::ACCESS_MODE_INPUT, DbType::NEED_DATA, &DbValidator::aaDb},
+                                   {"codingFragmentsDB", DbType::ACCESS_MODE_OUTPUT, DbType::NEED_DATA, &DbValidator::aaDb}}},
         {"collectoptimalset",             collectoptimalset,            &localPar.collectoptimalset,    COMMAND_EXPERT,
                 "Collect the optimal set of exons for a target protein/profile",
                 "A dynamic programming procedure on all candidates of each contig and strand combination",
@@ -13,6 +13,10 @@ void setEasyPredictDefaults(Parameters *p) {
     // evalue for search is high by default
     // The metaeuk Evalue Thr is lower
     p->evalThr = 100;
+    // plan the prefilter splits with the length distribution of the ORF fragments
+    p->splitMode = Parameters::THROUGHPUT_DB_SPLIT;
+    // contigs in plain fasta are only indexed, their sequences are read from the input file
+    p->createdbMode = Parameters::SEQUENCE_SPLIT_MODE_SOFT;
 }
 
 int easypredict(int argc, const char **argv, const Command& command) {
@@ -30,11 +34,17 @@ int easypredict(int argc, const char **argv, const Command& command) {
     par.filenames.push_back(tmpDir);
 
     CommandCaller cmd;
+    cmd.addVariable("RUNNER", par.runner.c_str());
     cmd.addVariable("PREDICTEXONS_PAR", par.createParameterString(par.predictexonsworkflow).c_str());
     cmd.addVariable("REDUCEREDUNDANCY_PAR", par.createParameterString(par.reduceredundancy).c_str());
     cmd.addVariable("UNITESETSTOFASTA_PAR", par.createParameterString(par.unitesetstofasta).c_str());
-    cmd.addVariable("VERBOSITY_COMP_PAR", par.createParameterString(par.verbandcompression).c_str());
     cmd.addVariable("THREAD_COMP_PAR", par.createParameterString(par.threadsandcompression).c_str());
+    // fasta targets are converted into a database that outlives the tmp directory, so that its index is reused
+    std::string targetDb = par.targetDbPath.empty() ? par.db2 + "_db" : par.targetDbPath;
+    cmd.addVariable("VERBOSITY_PAR", par.createParameterString(par.onlyverbosity).c_str());
+    cmd.addVariable("TARGET_DB", par.createTargetIndex == 1 ? targetDb.c_str() : NULL);
+    // a soft linked database cannot be shuffled, createdb falls back to copying multiline or compressed fasta
+    cmd.addVariable("CONTIGS_CREATEDB_PAR", par.createdbMode == Parameters::SEQUENCE_SPLIT_MODE_SOFT ? "--createdb-mode 1 --shuffle 0" : NULL);
 
     std::string program(tmpDir + "/easypredict.sh");
     FileUtil::writeFile(program, easypredict_sh, easypredict_sh_len);
@@ -0,0 +1,50 @@
+#include "Util.h"
+#include "CommandCaller.h"
+#include "Debug.h"
+#include "FileUtil.h"
+#include "LocalParameters.h"
+#include "predictbatch.sh.h"
+
+extern void setPredictExonsDefaults(Parameters *p);
+
+void setPredictBatchDefaults(Parameters *p) {
+    // every sample is predicted by predictexons, so the batch uses its defaults
+    setPredictExonsDefaults(p);
+}
+
+int predictbatch(int argc, const char **argv, const Command& command) {
+    LocalParameters& par = LocalParameters::getLocalInstance();
+    setPredictBatchDefaults(&par);
+    par.parseParameters(argc, argv, command, true, Parameters::PARSE_VARIADIC, 0);
+
+    std::string tmpDir = par.filenames.back();
+    std::string hash = SSTR(par.hashParameter(command.databases, par.filenames, *command.params));
+    if (par.reuseLatest) {
+        hash = FileUtil::getHashFromSymLink(tmpDir + "/latest");
+    }
+    tmpDir = FileUtil::createTemporaryDirectory(tmpDir, hash);
+    par.filenames.pop_back();
+
+    // the remaining paths are the contig DBs of the samples
+    CommandCaller cmd;
+    cmd.addVariable("TMP_PATH", tmpDir.c_str());
+    cmd.addVariable("RESULTS", par.filenames.back().c_str());
+    par.filenames.pop_back();
+    cmd.addVariable("INPUT_TARGETS", par.filenames.back().c_str());
+    par.filenames.pop_back();
+
+    cmd.addVariable("REMOVE_TMP", par.removeTmpFiles ? "TRUE" : NULL);
+    cmd.addVariable("RUNNER", par.runner.c_str());
+    cmd.addVariable("CONCATCONTIGS_PAR", par.createParameterString(par.onlythreads).c_str());
+    cmd.addVariable("PREDICTEXONS_PAR", par.createParameterString(par.predictexonsworkflow).c_str());
+    cmd.addVariable("REDUCEREDUNDANCY_PAR", par.createParameterString(par.reduceredundancy).c_str());
+    cmd.addVariable("UNITESETSTOFASTA_PAR", par.createParameterString(par.unitesetstofasta).c_str());
+    cmd.addVariable("VERBOSITY_PAR", par.createParameterString(par.onlyverbosity).c_str());
+
+    std::string program(tmpDir + "/predictbatch.sh");
+    FileUtil::writeFile(program, predictbatch_sh, predictbatch_sh_len);
+    cmd.execProgram(program.c_str(), par.filenames);
+
+    // should never get here
+    return EXIT_FAILURE;
+}
@@ -3,6 +3,7 @@
 #include "Debug.h"
 #include "FileUtil.h"
 #include "LocalParameters.h"
+#include "PrefilteringIndexReader.h"
 #include "predictexons.sh.h"
 
 void setPredictExonsDefaults(Parameters *p) {
@@ -13,6 +14,8 @@ void setPredictExonsDefaults(Parameters *p) {
     // evalue for search is high by default
     // The metaeuk Evalue Thr is lower
     p->evalThr = 100;
+    // plan the prefilter splits with the length distribution of the ORF fragments
+    p->splitMode = Parameters::THROUGHPUT_DB_SPLIT;
 }
 
 int predictexons(int argc, const char **argv, const Command& command) {
@@ -24,6 +27,34 @@ int predictexons(int argc, const char **argv, const Command& command) {
         Debug(Debug::INFO) << "Enforcing exhaustive profile search mode due to profile target database\n";
         par.exhaustiveSearch = true;
     }
+    // the prefilter index is only used by the k-mer prefilter of protein targets
+    bool canUseTargetIndex = (par.exhaustiveSearch == false) && (Parameters::isEqualDbtype(targetDbType, Parameters::DBTYPE_HMM_PROFILE) == false);
+    bool hasTargetIndex = (PrefilteringIndexReader::searchForIndex(par.db2) != "");
+    bool useTargetIndex = canUseTargetIndex && (hasTargetIndex || par.createTargetIndex == 1);
+    if (useTargetIndex && par.PARAM_PRELOAD_MODE.wasSet == false) {
+        // map the index instead of reading it into private memory,
+        // so concurrent jobs against the same targets share its pages
+        par.preloadMode = Parameters::PRELOAD_MODE_MMAP_TOUCH;
+    }
+    // the exon chaining only needs coordinates, scores and the sequence identity of the search hits:
+    // the coordinate-only alignment mode finds start positions with the reverse pass and estimates the identity,
+    // so no traceback is computed and collectoptimalset gets exactly the columns it expects
+    if (par.addBacktrace) {
+        Debug(Debug::WARNING) << "Backtraces are not used by predictexons and will not be computed\n";
+        par.addBacktrace = false;
+    }
+    if (par.realign) {
+        Debug(Debug::WARNING) << "Realignment requires backtraces and is disabled in predictexons\n";
+        par.realign = false;
+    }
+    if (par.alignmentMode == Parameters::ALIGNMENT_MODE_FAST_AUTO || par.alignmentMode == Parameters::ALIGNMENT_MODE_SCORE_ONLY) {
+        Debug(Debug::WARNING) << "predictexons requires alignment start positions. Setting --alignment-mode to " << Parameters::ALIGNMENT_MODE_SCORE_COV << "\n";
+        par.alignmentMode = Parameters::ALIGNMENT_MODE_SCORE_COV;
+    }
+    if (par.filterNoncoding == 1 && Parameters::isEqualDbtype(targetDbType, Parameters::DBTYPE_AMINO_ACIDS) == false) {
+        Debug(Debug::WARNING) << "The noncoding fragment filter needs protein sequence targets and is disabled\n";
+        par.filterNoncoding = 0;
+    }
     par.printParameters(command.cmd, argc, argv, *command.params);
 
     std::string tmpDir = par.db4;
@@ -37,12 +68,32 @@ int predictexons(int argc, const char **argv, const Command& command) {
 
     CommandCaller cmd;
     cmd.addVariable("REMOVE_TMP", par.removeTmpFiles ? "TRUE" : NULL);
+    cmd.addVariable("RUNNER", par.runner.c_str());
     cmd.addVariable("REVERSE_FRAGMENTS", par.reverseFragments == 1 ? "TRUE" : NULL);
+    cmd.addVariable("CREATE_TARGET_INDEX", (canUseTargetIndex && par.createTargetIndex == 1) ? "TRUE" : NULL);
+    // an existing index is kept if it matches the search parameters
+    if (par.PARAM_CHECK_COMPATIBLE.wasSet == false) {
+        par.checkCompatible = 1;
+    }
+    cmd.addVariable("INDEXDB_PAR", par.createParameterString(par.indexdb).c_str());
     cmd.addVariable("EXTRACTORFS_PAR", par.createParameterString(par.extractorfs).c_str());
     cmd.addVariable("TRANSLATENUCS_PAR", par.createParameterString(par.translatenucs).c_str());
+    cmd.addVariable("FILTER_NONCODING", par.filterNoncoding == 1 ? "TRUE" : NULL);
+    cmd.addVariable("FILTERNONCODING_PAR", par.createParameterString(par.filternoncoding).c_str());
     // align module should return alignments of at least a minimal exon length
     par.alnLenThr = par.minExonAaLength;
     cmd.addVariable("SEARCH_PAR", par.createParameterString(par.searchworkflow).c_str());
+    if (par.fastPassSensitivity > 0) {
+        // the fast pass only differs in its sensitivity from the full search
+        float sensitivity = par.sensitivity;
+        par.sensitivity = par.fastPassSensitivity;
+        cmd.addVariable("FAST_SEARCH_PAR", par.createParameterString(par.searchworkflow).c_str());
+        par.sensitivity = sensitivity;
+        // fragments at most an intron away from an optimal set are searched again
+        cmd.addVariable("MAX_INTRON", SSTR(par.maxIntronLength).c_str());
+        cmd.addVariable("VERBOSITY_COMP_PAR", par.createParameterString(par.verbandcompression).c_str());
+        cmd.addVariable("VERBOSITY_PAR", par.createParameterString(par.onlyverbosity).c_str());
+    }
     cmd.addVariable("THREAD_COMP_PAR", par.createParameterString(par.threadsandcompression).c_str());
     cmd.addVariable("COLLECTOPTIMALSET_PAR", par.createParameterString(par.collectoptimalset).c_str());
 